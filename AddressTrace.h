@@ -0,0 +1,388 @@
+#ifndef ADDRESSTRACE_H
+#define ADDRESSTRACE_H
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "PageReplacement.h"
+
+/*
+ * Address traces record the byte addresses a program touched rather than
+ * page numbers. Two line formats are understood and may be mixed:
+ *
+ *   valgrind lackey   "I  04011000,3", " L 7ff0001a,8", " S ...", " M ..."
+ *                     where I is an instruction fetch and L, S and M
+ *                     (load, store, modify) are data references. Lines
+ *                     starting with "==" are valgrind's own output and are
+ *                     skipped.
+ *   raw addresses     one hex address per line, with or without 0x and
+ *                     optionally followed by ",size". These count as data
+ *                     references.
+ *
+ * Every address is turned into a page by dropping the low page_shift bits.
+ * A reference whose bytes cross a page boundary touches every page it
+ * covers, up to a few thousand; a reference covering more than that is a
+ * broken line and counts as malformed. Pages are numbered 0, 1, 2, ... in the order they are first seen,
+ * so 64 bit addresses fit the int page ids the algorithms use and the ids
+ * stay dense. Consecutive duplicate pages are dropped as they are parsed,
+ * so what comes out is a clean reference string.
+ */
+
+/*!
+ * \brief The AddressTraceOptions struct says how addresses become pages
+ */
+struct AddressTraceOptions
+{
+    // log2 of the page size, 12 for 4K pages
+    int page_shift = 12;
+    // Which references make it into the reference string
+    bool instructions = true;
+    bool data = true;
+
+    /*!
+     * \brief ParsePageSize sets page_shift from a page size such as 4K, 2M,
+     * 1G or a plain number of bytes
+     * \return False if text is not a power of two number of bytes
+     */
+    bool ParsePageSize(const std::string& text)
+    {
+        char* end = nullptr;
+        unsigned long long size = std::strtoull(text.c_str(), &end, 10);
+        if (end == text.c_str())
+        {
+            return false;
+        }
+
+        std::string unit(end);
+        if (unit == "K" || unit == "k" || unit == "KB")
+        {
+            size <<= 10;
+        }
+        else if (unit == "M" || unit == "m" || unit == "MB")
+        {
+            size <<= 20;
+        }
+        else if (unit == "G" || unit == "g" || unit == "GB")
+        {
+            size <<= 30;
+        }
+        else if (!unit.empty())
+        {
+            return false;
+        }
+
+        if (size == 0 || (size & (size - 1)) != 0)
+        {
+            return false;
+        }
+        page_shift = CountTrailingZeros((uint64_t) size);
+        return true;
+    }
+};
+
+/*!
+ * \brief The AddressTraceParser class turns the text of an address trace into
+ * a reference string. Text is handed over in chunks straight from the read
+ * buffer and parsed in place; only the pages come out.
+ */
+class AddressTraceParser
+{
+public:
+    explicit AddressTraceParser(const AddressTraceOptions& options = AddressTraceOptions())
+        : options_(options)
+    {
+    }
+
+    /*!
+     * \brief Parse parses every complete line in a chunk of text and appends
+     * their pages to Pages()
+     * \param text Start of the chunk
+     * \param size Size of the chunk in bytes
+     * \param last Whether this is the end of the trace, in which case a final
+     * line without a newline is parsed too
+     * \return Number of bytes parsed. The rest is an incomplete line that
+     * has to be handed over again at the start of the next chunk.
+     */
+    size_t Parse(const char* text, size_t size, bool last)
+    {
+        const char* end = text + size;
+        const char* line = text;
+        for (;;)
+        {
+            const char* newline = static_cast<const char*>(std::memchr(line, '\n', end - line));
+            if (newline == nullptr)
+            {
+                if (!last || line == end)
+                {
+                    break;
+                }
+                newline = end;
+            }
+
+            ParseLine(line, newline);
+            line = newline == end ? end : newline + 1;
+        }
+        return line - text;
+    }
+
+    /*!
+     * \brief Pages holds the pages parsed since the last call to ClearPages()
+     */
+    std::vector<int>& Pages() { return pages_; }
+    void ClearPages() { pages_.clear(); }
+
+    uint64_t NumLines() const { return num_lines_; }
+    uint64_t NumInstructionReferences() const { return num_instructions_; }
+    uint64_t NumDataReferences() const { return num_data_; }
+    uint64_t NumMalformedLines() const { return num_malformed_; }
+    // Line number of the first malformed line, 0 if there is none
+    uint64_t FirstMalformedLine() const { return first_malformed_; }
+    // Number of distinct pages and the address of every page id
+    int NumPages() const { return (int) page_addresses_.size(); }
+    uint64_t PageAddress(int page) const { return page_addresses_[page] << options_.page_shift; }
+
+private:
+    // Most pages a single reference may cover
+    enum { kMaxReferencePages = 4096 };
+
+    /*!
+     * \brief ParseLine parses a single line without its newline
+     */
+    void ParseLine(const char* p, const char* end)
+    {
+        num_lines_ += 1;
+
+        while (p != end && (*p == ' ' || *p == '\t'))
+        {
+            ++p;
+        }
+        if (end != p && end[-1] == '\r')
+        {
+            --end;
+        }
+        if (p == end || (end - p >= 2 && p[0] == '=' && p[1] == '='))
+        {
+            return;
+        }
+
+        // A lackey line starts with its kind, anything else is an address
+        bool instruction = false;
+        if (end - p >= 2 && (p[1] == ' ' || p[1] == '\t') &&
+            (p[0] == 'I' || p[0] == 'L' || p[0] == 'S' || p[0] == 'M'))
+        {
+            instruction = p[0] == 'I';
+            p += 2;
+            while (p != end && (*p == ' ' || *p == '\t'))
+            {
+                ++p;
+            }
+        }
+
+        if (end - p >= 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+        {
+            p += 2;
+        }
+
+        uint64_t address = 0;
+        int digits = 0;
+        for (; p != end; ++p, ++digits)
+        {
+            int digit = HexDigit(*p);
+            if (digit < 0)
+            {
+                break;
+            }
+            address = (address << 4) | (uint64_t) digit;
+        }
+
+        uint64_t size = 1;
+        if (p != end && *p == ',')
+        {
+            ++p;
+            size = 0;
+            const char* first = p;
+            for (; p != end && *p >= '0' && *p <= '9'; ++p)
+            {
+                size = size * 10 + (uint64_t) (*p - '0');
+            }
+            // Longer sizes would overflow, and are far too large anyway
+            if (p == first || p - first > 9 || size == 0)
+            {
+                digits = 0;
+            }
+        }
+
+        while (p != end && (*p == ' ' || *p == '\t'))
+        {
+            ++p;
+        }
+
+        // The last byte saturates so a reference at the top of the address
+        // space does not wrap around to page 0. Sizes are a few bytes, one
+        // that covers thousands of pages is a broken line rather than a
+        // request for every one of them.
+        uint64_t last_byte = address + (size - 1);
+        if (last_byte < address)
+        {
+            last_byte = UINT64_MAX;
+        }
+        uint64_t first_page = address >> options_.page_shift;
+        uint64_t last_page = last_byte >> options_.page_shift;
+
+        if (digits == 0 || digits > 16 || p != end || last_page - first_page >= kMaxReferencePages)
+        {
+            num_malformed_ += 1;
+            if (first_malformed_ == 0)
+            {
+                first_malformed_ = num_lines_;
+            }
+            return;
+        }
+
+        if (instruction)
+        {
+            num_instructions_ += 1;
+            if (!options_.instructions)
+            {
+                return;
+            }
+        }
+        else
+        {
+            num_data_ += 1;
+            if (!options_.data)
+            {
+                return;
+            }
+        }
+
+        for (uint64_t page = first_page; ; ++page)
+        {
+            AddPage(page);
+            if (page == last_page)
+            {
+                break;
+            }
+        }
+    }
+
+    void AddPage(uint64_t page)
+    {
+        // Most references are on the same page as the one before, which
+        // needs neither a lookup nor a new entry in the reference string
+        if (has_last_ && page == last_page_)
+        {
+            return;
+        }
+
+        auto it = page_ids_.find(page);
+        int id;
+        if (it == page_ids_.end())
+        {
+            id = (int) page_addresses_.size();
+            page_ids_.emplace(page, id);
+            page_addresses_.push_back(page);
+        }
+        else
+        {
+            id = it->second;
+        }
+
+        pages_.push_back(id);
+        last_page_ = page;
+        has_last_ = true;
+    }
+
+    static int HexDigit(char c)
+    {
+        if (c >= '0' && c <= '9')
+        {
+            return c - '0';
+        }
+        c |= 0x20;
+        if (c >= 'a' && c <= 'f')
+        {
+            return c - 'a' + 10;
+        }
+        return -1;
+    }
+
+    AddressTraceOptions options_;
+    // Pages parsed since the last ClearPages()
+    std::vector<int> pages_;
+    // Id of every page seen so far and the page of every id
+    std::unordered_map<uint64_t, int> page_ids_;
+    std::vector<uint64_t> page_addresses_;
+    // Last page added to the reference string
+    bool has_last_ = false;
+    uint64_t last_page_ = 0;
+
+    uint64_t num_lines_ = 0;
+    uint64_t num_instructions_ = 0;
+    uint64_t num_data_ = 0;
+    uint64_t num_malformed_ = 0;
+    uint64_t first_malformed_ = 0;
+};
+
+/*!
+ * \brief ReadAddressTrace parses a whole address trace from a file in fixed
+ * size chunks, handing the pages of every chunk to consume as a
+ * RefStringView. To simulate straight from the file pass a lambda that calls
+ * AccessMany on a page cache; nothing but the current chunk is ever held.
+ * \param file File to read, which is left open
+ * \param parser Parser to use, which keeps the counts and page addresses
+ * \param consume Called with the pages of every chunk
+ * \return False if the file could not be read
+ */
+template <class Consumer>
+bool ReadAddressTrace(std::FILE* file, AddressTraceParser& parser, Consumer consume)
+{
+    std::vector<char> buffer(1 << 20);
+    size_t filled = 0;
+    bool last = false;
+
+    while (!last)
+    {
+        filled += std::fread(buffer.data() + filled, 1, buffer.size() - filled, file);
+        last = filled < buffer.size();
+        if (last && std::ferror(file))
+        {
+            return false;
+        }
+
+        // A line longer than the whole buffer is cut and parsed as it is
+        size_t parsed = parser.Parse(buffer.data(), filled, last);
+        if (parsed == 0 && filled == buffer.size())
+        {
+            parsed = parser.Parse(buffer.data(), filled, true);
+        }
+
+        std::memmove(buffer.data(), buffer.data() + parsed, filled - parsed);
+        filled -= parsed;
+
+        if (!parser.Pages().empty())
+        {
+            consume(RefStringView(parser.Pages()));
+            parser.ClearPages();
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief ReadAddressTrace parses a whole address trace from a file into a
+ * reference string
+ */
+inline bool ReadAddressTrace(std::FILE* file, AddressTraceParser& parser, std::vector<int>& ref_string)
+{
+    return ReadAddressTrace(file, parser, [&](RefStringView pages) {
+        ref_string.insert(ref_string.end(), pages.begin(), pages.end());
+    });
+}
+
+#endif // ADDRESSTRACE_H
@@ -0,0 +1,279 @@
+#ifndef LOCALITYPROFILER_H
+#define LOCALITYPROFILER_H
+
+#include <cstdio>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "PageReplacement.h"
+
+/*
+ * Locality profile of a reference string. Where CalculatePageFaults boils a
+ * trace down to one number for one algorithm, the profile describes the trace
+ * itself, so it can be looked at before picking an algorithm:
+ *
+ *   reuse distance  distinct pages requested between two requests of a page,
+ *                   counting the page itself. This is the LRU stack distance,
+ *                   a request hits under LRU with at least that many frames.
+ *   reuse time      requests between two requests of a page
+ *   working set     average number of distinct pages in the last tau
+ *                   requests (Denning's s(tau)) for tau = 1, 2, 4, ...
+ *
+ * The histograms have one bucket per power of two, which keeps them small on
+ * any trace and is what they are plotted against anyway.
+ */
+
+/*!
+ * \brief The LogHistogram struct counts positive values in power of two
+ * buckets. Bucket k holds the values in [2^k, 2^(k+1)). First requests have
+ * no distance or time and are counted as cold.
+ */
+struct LogHistogram
+{
+    std::vector<uint64_t> counts;
+    uint64_t cold = 0;
+
+    void Add(uint64_t value)
+    {
+        int bucket = BucketOf(value);
+        if (bucket >= (int) counts.size())
+        {
+            counts.resize(bucket + 1, 0);
+        }
+        counts[bucket] += 1;
+    }
+
+    /*!
+     * \brief BucketOf returns the bucket of a value, floor(log2(value))
+     */
+    static int BucketOf(uint64_t value)
+    {
+        int bucket = 0;
+        while (value > 1)
+        {
+            value >>= 1;
+            bucket += 1;
+        }
+        return bucket;
+    }
+
+    static uint64_t LowerBound(int bucket) { return 1ull << bucket; }
+    static uint64_t UpperBound(int bucket) { return (1ull << (bucket + 1)) - 1; }
+};
+
+/*!
+ * \brief The LocalityProfile struct holds everything ProfileLocality measures
+ */
+struct LocalityProfile
+{
+    // Requests in the reference string and distinct pages among them
+    uint64_t num_references = 0;
+    uint64_t num_pages = 0;
+    LogHistogram reuse_distances;
+    LogHistogram reuse_times;
+    // working_set_sizes[k] is the average working set size with a window of
+    // 2^k requests
+    std::vector<double> working_set_sizes;
+    // Working set size after every timeline_window requests, with a window
+    // of timeline_window requests, if a window was given
+    int timeline_window = 0;
+    std::vector<int> working_set_timeline;
+};
+
+/*!
+ * \brief ProfileLocality measures the locality of a reference string in a
+ * single pass. Reuse distances come from a FenwickTree over the request
+ * times, with a 1 at the last request of every page, so the pass is
+ * O(n log n).
+ *
+ * The average working set sizes need no extra work: a request stays in the
+ * working set until its page is requested again or tau requests have gone
+ * by, so s(tau) is the average of min(tau, gap) over every request, where
+ * gap is the time to the next request of the page (or to the end). Keeping
+ * the count and the sum of the gaps in every power of two bucket gives
+ * s(tau) exactly for every power of two tau.
+ *
+ * \param ref_string Cleaned, ordered list of frame requests
+ * \param timeline_window Window of the working set timeline, 0 for none
+ * \return The profile
+ */
+inline LocalityProfile ProfileLocality(RefStringView ref_string, int timeline_window = 0)
+{
+    LocalityProfile profile;
+    const int length = (int) ref_string.size();
+    profile.num_references = (uint64_t) length;
+
+    const int dense_pages = PageSet::DensePagesFor(ref_string);
+    FenwickTree last_requests(length);
+    PageMap last_request_time(dense_pages);
+    // Every distinct page, to find the last requests once the pass is done
+    std::vector<int> pages;
+
+    // Count and sum of the gaps to the next request, per bucket
+    std::vector<uint64_t> gap_counts;
+    std::vector<uint64_t> gap_sums;
+    auto add_gap = [&](uint64_t gap) {
+        int bucket = LogHistogram::BucketOf(gap);
+        if (bucket >= (int) gap_counts.size())
+        {
+            gap_counts.resize(bucket + 1, 0);
+            gap_sums.resize(bucket + 1, 0);
+        }
+        gap_counts[bucket] += 1;
+        gap_sums[bucket] += gap;
+    };
+
+    // The working set is only simulated when a timeline was asked for
+    profile.timeline_window = timeline_window < 0 ? 0 : timeline_window;
+    std::unique_ptr<WorkingSetPageCache> working_set;
+    if (profile.timeline_window > 0)
+    {
+        working_set.reset(new WorkingSetPageCache(profile.timeline_window, dense_pages));
+    }
+
+    for (int t = 0; t < length; ++t)
+    {
+        int page = ref_string[t];
+        int previous = last_request_time.Find(page);
+
+        if (previous >= 0)
+        {
+            profile.reuse_distances.Add((uint64_t) last_requests.RangeSum(previous, t - 1));
+            profile.reuse_times.Add((uint64_t) (t - previous));
+            add_gap((uint64_t) (t - previous));
+            last_requests.Add(previous, -1);
+        }
+        else
+        {
+            profile.reuse_distances.cold += 1;
+            profile.reuse_times.cold += 1;
+            profile.num_pages += 1;
+            pages.push_back(page);
+        }
+
+        last_requests.Add(t, 1);
+        last_request_time.Set(page, t);
+
+        if (working_set)
+        {
+            working_set->Access(page);
+            if ((t + 1) % profile.timeline_window == 0)
+            {
+                profile.working_set_timeline.push_back(working_set->Size());
+            }
+        }
+    }
+
+    // The last request of every page stays in the working set until the end
+    for (int page : pages)
+    {
+        add_gap((uint64_t) (length - last_request_time.Find(page)));
+    }
+
+    // sum over requests of min(tau, gap) for tau = 2^k is the sum of the
+    // gaps in the buckets below k plus tau for every gap from bucket k up.
+    // Windows past the length of the string all give the same size.
+    uint64_t below_sum = 0;
+    uint64_t at_or_above = (uint64_t) length;
+    for (int k = 0; length > 0; ++k)
+    {
+        if (k > 0 && k - 1 < (int) gap_counts.size())
+        {
+            below_sum += gap_sums[k - 1];
+            at_or_above -= gap_counts[k - 1];
+        }
+
+        uint64_t tau = LogHistogram::LowerBound(k);
+        profile.working_set_sizes.push_back(((double) below_sum + (double) tau * (double) at_or_above) / (double) length);
+        if (tau >= (uint64_t) length)
+        {
+            break;
+        }
+    }
+
+    return profile;
+}
+
+/*!
+ * \brief WriteLocalityProfileCsv writes a profile as CSV with one row per
+ * histogram bucket, working set window and timeline point. Cold requests
+ * have inf bounds.
+ */
+inline void WriteLocalityProfileCsv(const LocalityProfile& profile, std::FILE* out)
+{
+    std::fprintf(out, "metric,lower,upper,value\n");
+
+    auto write_histogram = [&](const char* metric, const LogHistogram& histogram) {
+        for (int k = 0; k < (int) histogram.counts.size(); ++k)
+        {
+            std::fprintf(out, "%s,%llu,%llu,%llu\n", metric,
+                         (unsigned long long) LogHistogram::LowerBound(k),
+                         (unsigned long long) LogHistogram::UpperBound(k),
+                         (unsigned long long) histogram.counts[k]);
+        }
+        std::fprintf(out, "%s,inf,inf,%llu\n", metric, (unsigned long long) histogram.cold);
+    };
+
+    write_histogram("reuse_distance", profile.reuse_distances);
+    write_histogram("reuse_time", profile.reuse_times);
+
+    for (int k = 0; k < (int) profile.working_set_sizes.size(); ++k)
+    {
+        unsigned long long tau = (unsigned long long) LogHistogram::LowerBound(k);
+        std::fprintf(out, "working_set_size,%llu,%llu,%.6f\n", tau, tau, profile.working_set_sizes[k]);
+    }
+
+    for (size_t i = 0; i < profile.working_set_timeline.size(); ++i)
+    {
+        unsigned long long end = (unsigned long long) (i + 1) * profile.timeline_window;
+        std::fprintf(out, "working_set_timeline,%llu,%llu,%d\n",
+                     end - profile.timeline_window + 1, end, profile.working_set_timeline[i]);
+    }
+}
+
+/*!
+ * \brief WriteLocalityProfileJson writes a profile as a JSON object
+ */
+inline void WriteLocalityProfileJson(const LocalityProfile& profile, std::FILE* out)
+{
+    std::fprintf(out, "{\n  \"references\": %llu,\n  \"pages\": %llu,\n",
+                 (unsigned long long) profile.num_references, (unsigned long long) profile.num_pages);
+
+    auto write_histogram = [&](const char* name, const LogHistogram& histogram) {
+        std::fprintf(out, "  \"%s\": {\n    \"cold\": %llu,\n    \"buckets\": [", name,
+                     (unsigned long long) histogram.cold);
+        const char* separator = "\n";
+        for (int k = 0; k < (int) histogram.counts.size(); ++k)
+        {
+            std::fprintf(out, "%s      {\"lower\": %llu, \"upper\": %llu, \"count\": %llu}", separator,
+                         (unsigned long long) LogHistogram::LowerBound(k),
+                         (unsigned long long) LogHistogram::UpperBound(k),
+                         (unsigned long long) histogram.counts[k]);
+            separator = ",\n";
+        }
+        std::fprintf(out, "\n    ]\n  },\n");
+    };
+
+    write_histogram("reuse_distance", profile.reuse_distances);
+    write_histogram("reuse_time", profile.reuse_times);
+
+    std::fprintf(out, "  \"working_set_size\": [");
+    const char* separator = "\n";
+    for (int k = 0; k < (int) profile.working_set_sizes.size(); ++k)
+    {
+        std::fprintf(out, "%s    {\"window\": %llu, \"size\": %.6f}", separator,
+                     (unsigned long long) LogHistogram::LowerBound(k), profile.working_set_sizes[k]);
+        separator = ",\n";
+    }
+
+    std::fprintf(out, "\n  ],\n  \"timeline_window\": %d,\n  \"working_set_timeline\": [",
+                 profile.timeline_window);
+    for (size_t i = 0; i < profile.working_set_timeline.size(); ++i)
+    {
+        std::fprintf(out, "%s%d", i == 0 ? "" : ", ", profile.working_set_timeline[i]);
+    }
+    std::fprintf(out, "]\n}\n");
+}
+
+#endif // LOCALITYPROFILER_H
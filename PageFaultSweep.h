@@ -0,0 +1,276 @@
+#ifndef PAGEFAULTSWEEP_H
+#define PAGEFAULTSWEEP_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "PageReplacement.h"
+
+/*!
+ * \brief The WorkStealingThreadPool class runs tasks on a fixed set of worker
+ * threads. Every worker has its own task queue. Workers take work from the
+ * front of their own queue and, once that is empty, steal from the back of
+ * the other queues, so a worker that drew a few long tasks does not hold up
+ * the rest.
+ */
+class WorkStealingThreadPool
+{
+public:
+    /*!
+     * \brief WorkStealingThreadPool starts the worker threads
+     * \param num_threads Number of workers, 0 uses every hardware thread
+     */
+    explicit WorkStealingThreadPool(unsigned num_threads = 0)
+        : next_queue_(0), queued_(0), pending_(0), stopping_(false)
+    {
+        if (num_threads == 0)
+        {
+            num_threads = std::thread::hardware_concurrency();
+        }
+        if (num_threads == 0)
+        {
+            num_threads = 1;
+        }
+
+        for (unsigned i = 0; i < num_threads; ++i)
+        {
+            queues_.push_back(std::unique_ptr<TaskQueue>(new TaskQueue));
+        }
+        for (unsigned i = 0; i < num_threads; ++i)
+        {
+            workers_.push_back(std::thread(&WorkStealingThreadPool::WorkerLoop, this, i));
+        }
+    }
+
+    /*!
+     * \brief ~WorkStealingThreadPool runs every task that is still queued
+     * and then stops the workers
+     */
+    ~WorkStealingThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            stopping_ = true;
+        }
+        work_available_.notify_all();
+
+        for (auto& worker : workers_)
+        {
+            worker.join();
+        }
+    }
+
+    /*!
+     * \brief Submit queues a task. Tasks are spread over the worker queues
+     * round robin.
+     */
+    void Submit(std::function<void()> task)
+    {
+        TaskQueue& queue = *queues_[next_queue_++ % queues_.size()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            queued_ += 1;
+            pending_ += 1;
+        }
+        work_available_.notify_one();
+    }
+
+    /*!
+     * \brief Wait blocks until every submitted task has finished
+     */
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(state_mutex_);
+        all_done_.wait(lock, [this]() { return pending_ == 0; });
+    }
+
+    unsigned NumThreads() const { return (unsigned) workers_.size(); }
+
+private:
+    WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+    WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    /*!
+     * \brief TryPop takes a task from the worker's own queue or steals one
+     * \return True if a task was taken
+     */
+    bool TryPop(unsigned self, std::function<void()>& task)
+    {
+        const unsigned num_queues = (unsigned) queues_.size();
+
+        for (unsigned offset = 0; offset < num_queues; ++offset)
+        {
+            TaskQueue& queue = *queues_[(self + offset) % num_queues];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty())
+            {
+                continue;
+            }
+
+            // The owner runs its tasks in the order they were submitted and
+            // thieves take from the other end, so the owner and a thief rarely
+            // want the same task
+            if (offset == 0)
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            else
+            {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+    void WorkerLoop(unsigned self)
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            if (TryPop(self, task))
+            {
+                {
+                    std::lock_guard<std::mutex> lock(state_mutex_);
+                    queued_ -= 1;
+                }
+
+                task();
+
+                std::lock_guard<std::mutex> lock(state_mutex_);
+                pending_ -= 1;
+                if (pending_ == 0)
+                {
+                    all_done_.notify_all();
+                }
+                continue;
+            }
+
+            // Nothing to take, sleep until something is submitted. queued_
+            // counts the tasks sitting in any queue so a task that was pushed
+            // while this worker was looking is never missed.
+            std::unique_lock<std::mutex> lock(state_mutex_);
+            work_available_.wait(lock, [this]() { return stopping_ || queued_ > 0; });
+            if (queued_ == 0)
+            {
+                return;
+            }
+        }
+    }
+
+    // One queue per worker
+    std::vector<std::unique_ptr<TaskQueue>> queues_;
+    std::vector<std::thread> workers_;
+    // Queue the next submitted task goes to
+    std::atomic<unsigned> next_queue_;
+
+    // Guards the counters below
+    std::mutex state_mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable all_done_;
+    // Tasks that are in a queue and not taken yet
+    size_t queued_;
+    // Tasks that are submitted and not finished yet
+    size_t pending_;
+    // Set when the pool is destroyed
+    bool stopping_;
+};
+
+/*!
+ * \brief The PageFaultSweepResult struct holds the page faults of every
+ * algorithm at every frame count of a sweep
+ */
+struct PageFaultSweepResult
+{
+    // Algorithms in the order of the rows
+    std::vector<PageReplacementAlgorithm> algorithms;
+    // Frame counts in the order of the columns
+    std::vector<int> frame_counts;
+    // page_faults[algorithm][frame count]
+    std::vector<std::vector<int>> page_faults;
+    // Wall clock seconds every simulation took, same layout as page_faults
+    std::vector<std::vector<double>> seconds;
+};
+
+/*!
+ * \brief SweepPageFaults runs every algorithm at every frame count in
+ * [min_frames, max_frames]. Every simulation is independent, so they are all
+ * run in parallel on a WorkStealingThreadPool, and every one of them reads the
+ * same reference string without copying it.
+ * \param ref_string Cleaned, ordered list of frame requests
+ * \param algorithms Algorithms to run
+ * \param num_pages Number of pages in the system
+ * \param min_frames Smallest number of frames, counts below 1 are skipped
+ * \param max_frames Largest number of frames
+ * \param num_threads Number of threads, 0 uses every hardware thread
+ * \return The page faults of every algorithm at every frame count
+ */
+inline PageFaultSweepResult SweepPageFaults(RefStringView ref_string,
+                                            const std::vector<PageReplacementAlgorithm>& algorithms,
+                                            int num_pages, int min_frames, int max_frames,
+                                            unsigned num_threads = 0)
+{
+    PageFaultSweepResult result;
+    result.algorithms = algorithms;
+
+    // No engine can run without a frame, so such counts are left out of the
+    // sweep rather than handed to engines that would misbehave on them
+    if (min_frames < 1)
+    {
+        min_frames = 1;
+    }
+    for (int frames = min_frames; frames <= max_frames; ++frames)
+    {
+        result.frame_counts.push_back(frames);
+    }
+
+    const size_t num_columns = result.frame_counts.size();
+    result.page_faults.assign(algorithms.size(), std::vector<int>(num_columns, 0));
+    result.seconds.assign(algorithms.size(), std::vector<double>(num_columns, 0.0));
+
+    WorkStealingThreadPool pool(num_threads);
+
+    // Every task writes its own cell of the result so no locking is needed.
+    // The largest frame counts go in first because they tend to take longest.
+    for (size_t a = 0; a < algorithms.size(); ++a)
+    {
+        for (size_t column = num_columns; column-- > 0;)
+        {
+            pool.Submit([&result, ref_string, num_pages, a, column]() {
+                auto start = std::chrono::steady_clock::now();
+
+                std::unique_ptr<AbstractPageReplacement> page_replacement = CreatePageReplacement(
+                            result.algorithms[a], ref_string, num_pages, result.frame_counts[column]);
+                result.page_faults[a][column] = page_replacement->CalculatePageFaults();
+
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                result.seconds[a][column] = elapsed.count();
+            });
+        }
+    }
+
+    pool.Wait();
+    return result;
+}
+
+#endif // PAGEFAULTSWEEP_H
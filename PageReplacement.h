@@ -1,8 +1,129 @@
+#ifndef PAGEREPLACEMENT_H
+#define PAGEREPLACEMENT_H
+
 #include <vector>
+#include <algorithm>
 #include <iostream>
 #include <cstdlib>
 #include <deque>
 #include<set>
+#include <unordered_map>
+#include <unordered_set>
+#include <queue>
+#include <utility>
+#include <memory>
+#include <string>
+#include <cmath>
+
+#include "RefStringGenerator.h"
+
+/*!
+ * \brief The RefStringView class is a non-owning, read only view of a
+ * reference string. It is what the page replacement algorithms read from,
+ * so a reference string can live in a std::vector, a memory mapped trace
+ * file or anywhere else without being copied. Whoever owns the pages must
+ * keep them alive for as long as the view is used.
+ */
+class RefStringView
+{
+public:
+    typedef const int* const_iterator;
+    typedef const int* iterator;
+
+    RefStringView() : data_(nullptr), size_(0) {}
+    RefStringView(const int* data, size_t size) : data_(data), size_(size) {}
+    explicit RefStringView(const std::vector<int>& ref_string)
+        : data_(ref_string.data()), size_(ref_string.size()) {}
+
+    const int* begin() const { return data_; }
+    const int* end() const { return data_ + size_; }
+    const int* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const int& operator[](size_t index) const { return data_[index]; }
+
+    /*!
+     * \brief Slice returns a view of count pages starting at first
+     */
+    RefStringView Slice(size_t first, size_t count) const
+    {
+        return RefStringView(data_ + first, count);
+    }
+
+private:
+    // First page of the reference string
+    const int* data_;
+    // Number of pages in the reference string
+    size_t size_;
+};
+
+/*!
+ * \brief The RefStringCleaner class removes consecutive duplicate pages from
+ * a reference string that arrives in chunks. Every chunk is compacted in
+ * place in one pass and the last page kept is remembered, so a duplicate
+ * that straddles two chunks is removed as well. Cleaning a whole string is
+ * the same as filtering it as a single chunk.
+ */
+class RefStringCleaner
+{
+public:
+    RefStringCleaner() : has_last_(false), last_page_(0) {}
+
+    /*!
+     * \brief Filter compacts a chunk of pages in place
+     * \param pages First page of the chunk
+     * \param count Number of pages in the chunk
+     * \return Number of pages kept at the front of the chunk
+     */
+    size_t Filter(int* pages, size_t count)
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        size_t kept = 0;
+        size_t i = 0;
+
+        // The very first page of the stream is always kept
+        if (!has_last_)
+        {
+            last_page_ = pages[0];
+            has_last_ = true;
+            kept = 1;
+            i = 1;
+        }
+
+        // Always write the page and only advance past it when it differs
+        // from the last kept one. This has no branch to mispredict on the
+        // random mix of repeats that raw traces have.
+        int last_page = last_page_;
+        for (; i < count; ++i)
+        {
+            int page = pages[i];
+            pages[kept] = page;
+            kept += page != last_page;
+            last_page = page;
+        }
+        last_page_ = last_page;
+
+        return kept;
+    }
+
+    /*!
+     * \brief Reset forgets the last page so the next chunk starts a new string
+     */
+    void Reset()
+    {
+        has_last_ = false;
+    }
+
+private:
+    // Whether a page has been seen yet
+    bool has_last_;
+    // Last page of the previous chunk
+    int last_page_;
+};
 
 /*!
  * \brief The AbstractPageReplacement class is an abstract definition
@@ -30,14 +151,35 @@ public:
 	AbstractPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames)
 	{
 		// Set and clean the ref string
-        ref_string_ = ref_string;
-        AbstractPageReplacement::CleanRefString(ref_string_);
+        owned_ref_string_ = ref_string;
+        AbstractPageReplacement::CleanRefString(owned_ref_string_);
+        ref_string_ = RefStringView(owned_ref_string_);
 
 		// Set the number of pages and frames
         num_pages_ = num_pages;
         num_frames_ = num_frames;
     }
 
+    /*!
+     * \brief AbstractPageReplacement constructs the Page Replacement abstract class
+     * on top of a reference string that is owned by somebody else. Nothing is
+     * copied, so any number of algorithms can share one reference string (for
+     * example a MappedTrace). The pages must outlive this object and must already
+     * be clean, because a view cannot be cleaned in place.
+     *
+     * \param ref_string Cleaned, ordered list of frame requests
+     * \param num_pages Number of pages
+     * \param num_frames Number of frames
+     */
+    AbstractPageReplacement(RefStringView ref_string, int num_pages, int num_frames)
+    {
+        ref_string_ = ref_string;
+        num_pages_ = num_pages;
+        num_frames_ = num_frames;
+    }
+
+    virtual ~AbstractPageReplacement() {}
+
     /*!
      * \brief calculate_page_faults is a virtual function
      * for calculating the page faults. This needs
@@ -49,7 +191,9 @@ public:
     /*!
      * \brief generate_ref_string generates a random reference string
      * to be used in the page replacement algorithm. This is a random
-     * array of ints where no two consecutive numbers are equal.
+     * array of ints where no two consecutive numbers are equal. Every
+     * call uses a fresh seed, use the seeded overload to get the same
+     * reference string again.
      *
      * \param size Size of the reference string to generate
      * \param upper_bound Upper bound of the reference string
@@ -57,57 +201,39 @@ public:
      */
     static std::vector<int> GenerateRefString(int size, int upper_bound)
 	{
-		// Instantiate a new reference string a paramaterized size
-		std::vector<int> ref_string(size);
-
-		// If the user requested size zero then just return the array
-		// this is mostly a sanity check so this function doesn't 
-		// error out
-		if (size == 0) {
-			return ref_string;
-		}
-
-		// Set the 0th element as random outside the loop so the i-1th
-		// element can be checked all through the loop
-		ref_string[0] = rand() % upper_bound;
-
-		// Loop from 1 to requested size
-		for (int i = 1; i < size; ++i)
-		{
-			// Append a random number to the array
-			ref_string[i] = rand() % upper_bound;
-
-			// Loop while (and if) that just appended number is equal
-			// to the last element
-			while (ref_string[i] == ref_string[i - 1]) 
-			{
-				// Re-add a new random number to the array
-				ref_string[i] = rand() % upper_bound;
-			}
-		}
-
-		// Return the refernece string. C++ now does funcky magic
-		// to optimize this so it isn't a slow pass by value
-		return ref_string;
+        // Seeds come from a per thread counter that starts somewhere random,
+        // so calls on different threads never share any state
+        static thread_local uint64_t seed_counter = std::random_device()();
+        return GenerateRefString(size, upper_bound, Xoshiro256::SplitMix64(seed_counter));
 	}
 
+    /*!
+     * \brief generate_ref_string generates a random reference string from
+     * a seed. The same seed gives the same reference string on every platform.
+     * See RefStringGenerator for generating large strings on several threads.
+     *
+     * \param size Size of the reference string to generate
+     * \param upper_bound Upper bound of the reference string
+     * \param seed Seed of the reference string
+     * \return Randomly filled vector with no equivelent sequential elements
+     */
+    static std::vector<int> GenerateRefString(int size, int upper_bound, uint64_t seed)
+    {
+        // A negative size is treated the same as an empty request
+        return RefStringGenerator::Generate(size < 0 ? 0 : (size_t) size, upper_bound, seed);
+    }
+
     /*!
      * \brief clean_ref_string ensures that no two consecutive elements
      * are equal. If two elements are equal the one closer to the end
-     * of the array is removed. Cleaning is done in place.
+     * of the array is removed. Cleaning is done in place in a single
+     * linear pass that slides the kept elements forward, like std::unique.
      * \param ref_string Array to clean
      */
     static void CleanRefString(std::vector<int>& ref_string)
 	{
-		// Loop through the array backwards so we can remove an element
-		// and not mess up the indexing
-		for (auto i = ref_string.end(); i != ref_string.begin(); --i) { 
-			// If this element is equal to the one behind then remove
-			// the current element
-			if (*i == *(i - 1)) {
-				ref_string.erase(i);
-			}
-	    } 
+        RefStringCleaner cleaner;
+        ref_string.resize(cleaner.Filter(ref_string.data(), ref_string.size()));
 	}
 
     /*!
@@ -115,11 +241,12 @@ public:
      * and end functions of type T and finds the needle of type int
      * in that container
      * \param needle Element to query for
-     * \param haystack Deque to query in
+     * \param haystack Deque to query in. Taken by reference so the
+     * container is not copied on every lookup
      * \return True if element was found else False
      */
     template <class T>
-    static bool FindInContainer(int needle, T haystack) {
+    static bool FindInContainer(int needle, const T& haystack) {
         // Loop through the entire container
         for (auto i = haystack.begin(); i != haystack.end(); ++i)
         {
@@ -137,9 +264,17 @@ public:
 
 
 
+private:
+    // Copying would leave ref_string_ pointing into the other object's pages
+    AbstractPageReplacement(const AbstractPageReplacement&) = delete;
+    AbstractPageReplacement& operator=(const AbstractPageReplacement&) = delete;
+
 protected:
-    // Reference String
-    std::vector<int> ref_string_;
+    // Reference string read by the algorithms. Points either into
+    // owned_ref_string_ or into storage owned by the caller
+    RefStringView ref_string_;
+    // Cleaned copy of the reference string when the caller handed over a vector
+    std::vector<int> owned_ref_string_;
     // Number of pages in the system
     int num_pages_;
     // Number of frames in the system
@@ -165,6 +300,9 @@ public:
 	FIFOPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames) 
 	:AbstractPageReplacement(ref_string, num_pages, num_frames) {}
 
+    FIFOPageReplacement(RefStringView ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
     /*!
      * \brief calculate_page_faults calculates the number of page faults using
      * the FIFO algorithm. This algorithm swaps out pages in the main memory
@@ -182,7 +320,7 @@ public:
         int page_faults = 0;
 
         // Iterate through ths memory requests list
-        for (std::vector<int>::iterator i = ref_string_.begin(); i != ref_string_.end(); ++i)
+        for (auto i = ref_string_.begin(); i != ref_string_.end(); ++i)
 		{
             // If the currently requested page is not in memory then
             // it needs to be swapped in
@@ -225,6 +363,9 @@ public:
 	LRUPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames) 
 	:AbstractPageReplacement(ref_string, num_pages, num_frames) {}
 
+    LRUPageReplacement(RefStringView ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
     /*!
      * \brief CalculatePageFaults calculates the number of page faults using
      * the LRU algorithm. This algorithm swaps out pages in the main memory
@@ -277,10 +418,13 @@ public:
                     // If the currently requested page is in memory then delete
                     // its current position and add it on to the back of the array
                     // so it will not be chosen as the LRU
+                    // The page has to be erased before it is pushed because
+                    // push_back invalidates every iterator into a deque
 					if (*j == *i)
 					{
-                        current_pages.push_back(*j);
                         current_pages.erase(j);
+                        current_pages.push_back(*i);
+                        break;
 					}
 				}
 			}
@@ -292,117 +436,4628 @@ public:
 
 };
 
-class OPTPageReplacement: public AbstractPageReplacement
+/*!
+ * \brief The IndexedList class is a doubly linked list that lives in two
+ * flat arrays of ints instead of allocating a node per element. Nodes are
+ * identified by an index in [0, num_nodes) and every list owns a sentinel
+ * node stored after the regular nodes, so several lists can share the same
+ * pool of nodes and a node can be moved between them in O(1). A node must
+ * only be in one list at a time.
+ */
+class IndexedList
 {
 public:
-	OPTPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames) 
-	:AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+    /*!
+     * \brief IndexedList constructs the node pool and the empty lists
+     * \param num_nodes Number of nodes that can be linked into the lists
+     * \param num_lists Number of separate lists sharing the node pool
+     */
+    IndexedList(int num_nodes = 0, int num_lists = 1)
+    {
+        Reset(num_nodes, num_lists);
+    }
 
-    int CalculatePageFaults()
-	{
-		// Initialize a vector to store the memory_requests
-        std::vector <int> current_pages;
+    /*!
+     * \brief Reset unlinks every node and resizes the pool
+     * \param num_nodes Number of nodes that can be linked into the lists
+     * \param num_lists Number of separate lists sharing the node pool
+     */
+    void Reset(int num_nodes, int num_lists = 1)
+    {
+        num_nodes_ = num_nodes;
+        prev_.assign(num_nodes + num_lists, -1);
+        next_.assign(num_nodes + num_lists, -1);
+        sizes_.assign(num_lists, 0);
+        list_of_.assign(num_nodes, -1);
 
-		// Start the page_fault count
-		int page_faults = 0;
+        // An empty list is a sentinel that points at itself
+        for (int l = 0; l < num_lists; ++l)
+        {
+            prev_[End(l)] = End(l);
+            next_[End(l)] = End(l);
+        }
+    }
 
+    /*!
+     * \brief End returns the sentinel of a list. Walking the list with
+     * Next() from End() visits the nodes from front to back and stops
+     * when End() is reached again.
+     */
+    int End(int list) const { return num_nodes_ + list; }
 
-        for (auto i = ref_string_.begin(); i != ref_string_.end(); ++i)
-		{
-            // If the memory_requests is at maximum capacity AND it cannot be found then
-            // we have to shift the memory around. However if either one of those is false
-            // then we can just add it to the memory
-            if (current_pages.size() == (size_t) num_pages_ &&
-                !FindInContainer<std::vector<int>>(*i, current_pages))
-            {
-                // If the page that is being requested is not currently in memory
-                // then we need to find the page currently in memory that is furthest
-                // away from being requested again. We accomplish this using a vector
-                // with some extra fluff around accessing but this could be easily
-                // abstracted away to another class
-                //      1. An object within the set cannot be added again
-                //      2. The set will remain ordered
-                // These are both integral to how we are going to use the data structure.
-                // Conceptually we are using the set like a unique stack. Meaning that we append
-                // a value onto the top only if that element is not already in the stack. Then we can
-                // remove the page from the top of the stack (or any page that hasn't shown up
-                // in the stack if the stack's length is less than the frame length.
+    int Front(int list) const { return next_[End(list)]; }
+    int Back(int list) const { return prev_[End(list)]; }
+    int Next(int node) const { return next_[node]; }
+    int Prev(int node) const { return prev_[node]; }
+    bool Empty(int list) const { return sizes_[list] == 0; }
+    int Size(int list) const { return sizes_[list]; }
 
-                // Initialize the unique stack
-                std::vector<int> uniqueMemoryStack;
+    /*!
+     * \brief ListOf returns the list a node is linked into
+     * \return The list index or -1 if the node is not linked
+     */
+    int ListOf(int node) const { return list_of_[node]; }
 
-                // Loop through the rest of the memory adding each element to the stack
-                // if it is currently in memory.
-                for (auto j = i; j != ref_string_.end(); j++)
-                {
-                    // If the memory request isn't currently in memory then just continue
-                    if(!FindInContainer<std::vector<int>>(*j, current_pages))
-                    {
-                        continue;
-                    }
+    /*!
+     * \brief InsertBefore links a node in front of another node. The other
+     * node may be a sentinel, in which case the node goes to the back of
+     * that list.
+     */
+    void InsertBefore(int position, int node, int list)
+    {
+        prev_[node] = prev_[position];
+        next_[node] = position;
+        next_[prev_[position]] = node;
+        prev_[position] = node;
+        list_of_[node] = list;
+        sizes_[list] += 1;
+    }
 
-                    // If the memory request is in memory then add it to the unique stack
-                    if(!FindInContainer<std::vector<int>>(*j, uniqueMemoryStack))
-                    {
-                        uniqueMemoryStack.push_back(*j);
-                    }
-                }
+    void PushBack(int list, int node) { InsertBefore(End(list), node, list); }
+    void PushFront(int list, int node) { InsertBefore(Front(list), node, list); }
 
-                // Now there are two cases that we have to check to find the memory frame
-                // that is the furthest away from being used. If the size of the stack
-                // is equal to the number of pages then we can just pop the top of the stack
-                // and remove that item from the array
-                if (uniqueMemoryStack.size() == (size_t) num_pages_)
-                {
-                    // remove *uniqueMemoryStack.rbegin();
-                    for (auto j = current_pages.begin(); j != current_pages.end(); j++)
-                    {
-                        if (*j == *uniqueMemoryStack.rbegin())
-                        {
-                            current_pages.erase(j);
-                            break;
-                        }
-                    }
-                }
-                // If the length of the memory stack isnt equal to the number of pages then
-                // there exists a page in memory that isn't used in the rest of the running
-                // of the program. It makes sense to check and remove all elements that do
-                // not show up in this list. However even if we do that it will still cause
-                // a page fault when we try to access memory that isn't in the current pages
-                // To remove everything that isn't in the stack we iterate through the stack
-                // and replace every entry in the current pages with the entries in the stack
-                else
-                {
-                    for (auto j = current_pages.begin(); j != current_pages.end(); j++)
-                    {
-                        // If the page was not found in the memory stack then remove it
-                        if (!FindInContainer<std::vector<int>>(*j, uniqueMemoryStack))
-                        {
-                            current_pages.erase(j);
-                            break;
-                        }
-                    }
-                }
+    /*!
+     * \brief Remove unlinks a node from whichever list it is in
+     */
+    void Remove(int node)
+    {
+        next_[prev_[node]] = next_[node];
+        prev_[next_[node]] = prev_[node];
+        sizes_[list_of_[node]] -= 1;
+        list_of_[node] = -1;
+    }
 
+    /*!
+     * \brief MoveToBack unlinks a node and pushes it onto the back of a list
+     */
+    void MoveToBack(int list, int node)
+    {
+        Remove(node);
+        PushBack(list, node);
+    }
 
-                current_pages.push_back(*i);
-                page_faults += 1;
-            }
+private:
+    // Number of regular (non sentinel) nodes
+    int num_nodes_;
+    // Links towards the front of the list
+    std::vector<int> prev_;
+    // Links towards the back of the list
+    std::vector<int> next_;
+    // Number of nodes in every list
+    std::vector<int> sizes_;
+    // List every node is linked into
+    std::vector<int> list_of_;
+};
 
-            // If the current pages in memory is not equal to the maximum number of pages that
-            // can be contained in memory then the it is a page fault but it is handled differently
-            // We can just add to the page fault count and push the page into memory. If this
-            // algorithm was going to be used in a prod setting then these would be factored
-            // out so that the conditions were only checked once but I am leaving them here
-            // for readability.
-            else if (current_pages.size() != (size_t) num_frames_ &&
-                     !FindInContainer<std::vector<int>>(*i, current_pages))
-            {
-                page_faults += 1;
-                current_pages.push_back(*i);
-            }
-		}
+/*!
+ * \brief The PageSet class is a set of pages tuned for page ids that are
+ * small non negative ints, which is what reference strings nearly always
+ * hold. Pages in [0, dense_pages) are a single bit in a bitmap, so looking
+ * them up, adding and removing them never allocates or hashes. Any other
+ * page falls back to a hash set.
+ */
+class PageSet
+{
+public:
+    /*!
+     * \brief PageSet constructs an empty set
+     * \param dense_pages Pages below this are kept in the bitmap
+     */
+    explicit PageSet(int dense_pages = 0)
+    {
+        dense_pages_ = dense_pages < 0 ? 0 : dense_pages;
+        bits_.assign((dense_pages_ + 63) / 64, 0);
+    }
 
-		return page_faults;
-	}
+    bool Contains(int page) const
+    {
+        if ((unsigned) page < (unsigned) dense_pages_)
+        {
+            return (bits_[page >> 6] >> (page & 63)) & 1;
+        }
+        return sparse_.count(page) != 0;
+    }
+
+    void Insert(int page)
+    {
+        if ((unsigned) page < (unsigned) dense_pages_)
+        {
+            bits_[page >> 6] |= 1ull << (page & 63);
+            return;
+        }
+        sparse_.insert(page);
+    }
+
+    void Erase(int page)
+    {
+        if ((unsigned) page < (unsigned) dense_pages_)
+        {
+            bits_[page >> 6] &= ~(1ull << (page & 63));
+            return;
+        }
+        sparse_.erase(page);
+    }
+
+    void Clear()
+    {
+        std::fill(bits_.begin(), bits_.end(), 0);
+        sparse_.clear();
+    }
+
+    /*!
+     * \brief Reserve makes room for pages outside the bitmap
+     */
+    void Reserve(size_t count)
+    {
+        sparse_.reserve(count);
+    }
+
+    // Largest dense range DensePagesFor picks. The same size is used for
+    // PageMap, where it is an int per page, so it stays at 16 MiB there.
+    enum { kMaxDensePages = 1 << 22 };
+
+    /*!
+     * \brief DensePagesFor picks a dense range for a reference string, for a
+     * PageSet or a PageMap. The range covers every page up to the largest one
+     * in the string as long as the ids are packed, that is the largest is
+     * within a small multiple of the length of the string, and the range
+     * stays under max_dense_pages. Otherwise nothing is dense, so a few huge
+     * ids in a short string never allocate a table far larger than the
+     * string itself.
+     * \param ref_string Reference string that will be put through the set
+     * \param max_dense_pages Largest range to allocate, in pages
+     * \return The number of dense pages to construct a PageSet or PageMap with
+     */
+    static int DensePagesFor(RefStringView ref_string, int max_dense_pages = kMaxDensePages)
+    {
+        int largest = -1;
+        for (auto i = ref_string.begin(); i != ref_string.end(); ++i)
+        {
+            largest = *i > largest ? *i : largest;
+        }
+
+        // Short strings of small ids, like the ones typed into the GUI, are
+        // always dense
+        size_t packed_pages = ref_string.size() * 4 + 4096;
+        if (largest >= max_dense_pages || (size_t) largest >= packed_pages)
+        {
+            return 0;
+        }
+        return largest + 1;
+    }
+
+private:
+    // Pages in [0, dense_pages_) are bits in bits_
+    int dense_pages_;
+    std::vector<uint64_t> bits_;
+    // Every other page
+    std::unordered_set<int> sparse_;
 };
+
+/*!
+ * \brief The PageMap class maps pages to non negative ints (usually the frame
+ * a page is held in) the same way PageSet stores pages: pages in
+ * [0, dense_pages) index straight into an array and every other page falls
+ * back to a hash table.
+ */
+class PageMap
+{
+public:
+    /*!
+     * \brief PageMap constructs an empty map
+     * \param dense_pages Pages below this are kept in the array
+     */
+    explicit PageMap(int dense_pages = 0)
+    {
+        dense_.assign(dense_pages < 0 ? 0 : dense_pages, -1);
+    }
+
+    /*!
+     * \brief Find returns the value of a page
+     * \return The value or -1 if the page is not in the map
+     */
+    int Find(int page) const
+    {
+        if ((unsigned) page < (unsigned) dense_.size())
+        {
+            return dense_[page];
+        }
+        auto found = sparse_.find(page);
+        return found == sparse_.end() ? -1 : found->second;
+    }
+
+    /*!
+     * \brief Set sets the value of a page, value must not be negative
+     */
+    void Set(int page, int value)
+    {
+        if ((unsigned) page < (unsigned) dense_.size())
+        {
+            dense_[page] = value;
+            return;
+        }
+        sparse_[page] = value;
+    }
+
+    void Erase(int page)
+    {
+        if ((unsigned) page < (unsigned) dense_.size())
+        {
+            dense_[page] = -1;
+            return;
+        }
+        sparse_.erase(page);
+    }
+
+    void Clear()
+    {
+        std::fill(dense_.begin(), dense_.end(), -1);
+        sparse_.clear();
+    }
+
+    /*!
+     * \brief Reserve makes room for pages outside the array
+     */
+    void Reserve(size_t count)
+    {
+        sparse_.reserve(count);
+    }
+
+private:
+    // Value of every page in [0, dense_.size()), -1 if absent
+    std::vector<int> dense_;
+    // Every other page
+    std::unordered_map<int, int> sparse_;
+};
+
+/*!
+ * \brief CountTrailingZeros returns the index of the lowest set bit of a
+ * non zero word
+ */
+inline int CountTrailingZeros(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int count = 0;
+    while (!(word & 1))
+    {
+        word >>= 1;
+        count += 1;
+    }
+    return count;
+#endif
+}
+
+/*!
+ * \brief HashPage mixes a page id into 64 well spread bits with the finalizer
+ * of SplitMix64, for sketches and samplers that must treat every page alike
+ * no matter how the ids are laid out
+ */
+inline uint64_t HashPage(int page)
+{
+    uint64_t hash = (uint32_t) page;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    return hash ^ (hash >> 31);
+}
+
+/*!
+ * \brief The PageAccessResult struct is what a streaming page cache reports
+ * for a single page request
+ */
+struct PageAccessResult
+{
+    // True if the page was already in memory
+    bool hit;
+    // True if a page had to be swapped out to make room
+    bool evicted;
+    // The page that was swapped out, only meaningful when evicted is set
+    int evicted_page;
+};
+
+/*!
+ * \brief The FIFOPageCache class is the FIFO algorithm as an online cache.
+ * Instead of being handed the whole reference string up front, pages are
+ * requested one at a time with Access, so it can sit behind a live system.
+ * The arrival order is a fixed ring buffer of frames and a PageSet tracks
+ * which pages are resident, so every request is O(1). When the page ids are
+ * known to be below some bound the PageSet is a bitmap and no request ever
+ * allocates. Otherwise memory use only depends on the number of frames.
+ */
+class FIFOPageCache
+{
+public:
+    /*!
+     * \brief FIFOPageCache constructs an empty cache
+     * \param num_frames Number of frames in the system
+     * \param dense_pages Pages below this are tracked in a bitmap, pass 0
+     * when the page ids are not bounded
+     */
+    explicit FIFOPageCache(int num_frames, int dense_pages = 0)
+        : resident_(dense_pages)
+    {
+        num_frames_ = num_frames < 0 ? 0 : num_frames;
+        frames_.assign(num_frames_, 0);
+        resident_.Reserve(dense_pages > 0 ? 0 : num_frames_ * 2);
+        Reset();
+    }
+
+    /*!
+     * \brief Access requests a page, swapping it in if it is not in memory
+     * \param page Requested page
+     * \return Whether the request hit and which page was swapped out, if any
+     */
+    PageAccessResult Access(int page)
+    {
+        PageAccessResult result = {true, false, 0};
+        if (resident_.Contains(page))
+        {
+            return result;
+        }
+
+        result.hit = false;
+        if (num_frames_ == 0)
+        {
+            return result;
+        }
+
+        // Once memory is full the oldest page is at the head of the ring and
+        // the new page takes over its frame
+        if (size_ == num_frames_)
+        {
+            result.evicted = true;
+            result.evicted_page = frames_[head_];
+            resident_.Erase(result.evicted_page);
+
+            frames_[head_] = page;
+            head_ = head_ + 1 == num_frames_ ? 0 : head_ + 1;
+        }
+        else
+        {
+            frames_[size_++] = page;
+        }
+
+        resident_.Insert(page);
+        return result;
+    }
+
+    /*!
+     * \brief AccessMany requests a batch of pages in order
+     * \param pages Requested pages
+     * \return The number of page faults in the batch
+     */
+    int AccessMany(RefStringView pages)
+    {
+        int page_faults = 0;
+        for (auto i = pages.begin(); i != pages.end(); ++i)
+        {
+            page_faults += !Access(*i).hit;
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Reset swaps every page out
+     */
+    void Reset()
+    {
+        resident_.Clear();
+        head_ = 0;
+        size_ = 0;
+    }
+
+    int NumFrames() const { return num_frames_; }
+    int Size() const { return size_; }
+    bool Contains(int page) const { return resident_.Contains(page); }
+
+private:
+    // Number of frames in the system
+    int num_frames_;
+    // Pages in arrival order, starting at head_ and wrapping around
+    std::vector<int> frames_;
+    // Frame holding the oldest page once memory is full
+    int head_;
+    // Number of frames in use
+    int size_;
+    // Pages currently in memory
+    PageSet resident_;
+};
+
+/*!
+ * \brief The LRUPageCache class is the LRU algorithm as an online cache with
+ * O(1) hits and misses. The frames are slots in an IndexedList ordered from
+ * least to most recently used and a hash table maps each resident page to
+ * its slot, so nothing is ever searched for. Memory use only depends on the
+ * number of frames.
+ */
+class LRUPageCache
+{
+public:
+    /*!
+     * \brief LRUPageCache constructs an empty cache
+     * \param num_frames Number of frames in the system
+     */
+    explicit LRUPageCache(int num_frames)
+    {
+        num_frames_ = num_frames < 0 ? 0 : num_frames;
+        frame_pages_.assign(num_frames_, 0);
+        resident_.reserve(num_frames_ * 2);
+        Reset();
+    }
+
+    /*!
+     * \brief Access requests a page, swapping it in if it is not in memory
+     * and making it the most recently used page
+     * \param page Requested page
+     * \return Whether the request hit and which page was swapped out, if any
+     */
+    PageAccessResult Access(int page)
+    {
+        PageAccessResult result = {true, false, 0};
+        auto found = resident_.find(page);
+
+        // On a hit the page just becomes the most recently used one
+        if (found != resident_.end())
+        {
+            recency_.MoveToBack(0, found->second);
+            return result;
+        }
+
+        result.hit = false;
+        if (num_frames_ == 0)
+        {
+            return result;
+        }
+
+        // Take a free frame if there is one, otherwise evict the
+        // least recently used page and reuse its frame
+        int frame;
+        if (used_frames_ < num_frames_)
+        {
+            frame = used_frames_++;
+        }
+        else
+        {
+            frame = recency_.Front(0);
+            recency_.Remove(frame);
+            result.evicted = true;
+            result.evicted_page = frame_pages_[frame];
+            resident_.erase(result.evicted_page);
+        }
+
+        frame_pages_[frame] = page;
+        resident_[page] = frame;
+        recency_.PushBack(0, frame);
+        return result;
+    }
+
+    /*!
+     * \brief AccessMany requests a batch of pages in order
+     * \param pages Requested pages
+     * \return The number of page faults in the batch
+     */
+    int AccessMany(RefStringView pages)
+    {
+        int page_faults = 0;
+        for (auto i = pages.begin(); i != pages.end(); ++i)
+        {
+            page_faults += !Access(*i).hit;
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Reset swaps every page out
+     */
+    void Reset()
+    {
+        recency_.Reset(num_frames_);
+        resident_.clear();
+        used_frames_ = 0;
+    }
+
+    int NumFrames() const { return num_frames_; }
+    int Size() const { return used_frames_; }
+    bool Contains(int page) const { return resident_.count(page) != 0; }
+
+private:
+    // Number of frames in the system
+    int num_frames_;
+    // Recency order of the frames, the front is the least recently used
+    IndexedList recency_;
+    // Page held in every frame
+    std::vector<int> frame_pages_;
+    // Resident page -> frame it is held in
+    std::unordered_map<int, int> resident_;
+    // Number of frames handed out so far
+    int used_frames_;
+};
+
+/*!
+ * \brief The HashedLRUPageReplacement class calculates the same page faults
+ * as LRUPageReplacement but does both hits and misses in O(1) by running the
+ * reference string through an LRUPageCache.
+ */
+class HashedLRUPageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief HashedLRUPageReplacement constructs a HashedLRUPageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system
+     */
+    HashedLRUPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    HashedLRUPageReplacement(RefStringView ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of page faults using
+     * the LRU algorithm in O(1) per memory request
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        LRUPageCache cache(num_frames_);
+        return cache.AccessMany(ref_string_);
+    }
+};
+
+/*!
+ * \brief The RingFIFOPageReplacement class calculates the same page faults as
+ * FIFOPageReplacement in O(1) per memory request instead of O(frames). It runs
+ * the reference string through a FIFOPageCache whose residency bitmap covers
+ * every page in the reference string, so no request allocates.
+ */
+class RingFIFOPageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief RingFIFOPageReplacement constructs a RingFIFOPageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system
+     */
+    RingFIFOPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    RingFIFOPageReplacement(RefStringView ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of page faults using
+     * the FIFO algorithm in O(1) per memory request
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        FIFOPageCache cache(num_frames_, PageSet::DensePagesFor(ref_string_));
+        return cache.AccessMany(ref_string_);
+    }
+};
+
+/*!
+ * \brief The FenwickTree class (binary indexed tree) keeps an array of
+ * counts that supports adding to one element and summing a prefix of the
+ * array, both in O(log n).
+ */
+class FenwickTree
+{
+public:
+    /*!
+     * \brief FenwickTree constructs a tree of size zeroed counts
+     * \param size Number of elements in the array
+     */
+    FenwickTree(int size = 0) : tree_(size + 1, 0) {}
+
+    /*!
+     * \brief Add adds delta to the element at index
+     */
+    void Add(int index, int delta)
+    {
+        for (int i = index + 1; i < (int) tree_.size(); i += i & -i)
+        {
+            tree_[i] += delta;
+        }
+    }
+
+    /*!
+     * \brief PrefixSum sums the elements in [0, index]
+     * \return The sum, or 0 when index is negative
+     */
+    int PrefixSum(int index) const
+    {
+        int sum = 0;
+        for (int i = index + 1; i > 0; i -= i & -i)
+        {
+            sum += tree_[i];
+        }
+        return sum;
+    }
+
+    /*!
+     * \brief RangeSum sums the elements in [first, last]
+     */
+    int RangeSum(int first, int last) const
+    {
+        return PrefixSum(last) - PrefixSum(first - 1);
+    }
+
+private:
+    // One based tree of partial sums
+    std::vector<int> tree_;
+};
+
+/*!
+ * \brief The LRUStackDistance class calculates the LRU page faults for every
+ * number of frames at once using Mattson's stack algorithm. LRU has the
+ * inclusion property, so a request hits with f frames exactly when its
+ * stack distance (the number of distinct pages requested since the last
+ * request of the same page, counting itself) is at most f. The distances
+ * are counted with a FenwickTree that marks the last request time of every
+ * page, which makes the whole curve O(n log n) in the reference string
+ * length no matter how many frame counts are wanted.
+ */
+class LRUStackDistance: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief LRUStackDistance constructs a LRUStackDistance
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system
+     */
+    LRUStackDistance(std::vector<int>& ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    LRUStackDistance(RefStringView ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of LRU page faults
+     * with num_frames frames
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        int frames = num_frames_ < 0 ? 0 : num_frames_;
+        return CalculateFaultCurve(frames)[frames];
+    }
+
+    /*!
+     * \brief CalculateFaultCurve calculates the LRU miss curve in a single
+     * pass over the reference string.
+     * \param max_frames Largest number of frames to report
+     * \return A vector of max_frames + 1 elements where element f is the
+     * number of page faults LRU gives with f frames
+     */
+    std::vector<int> CalculateFaultCurve(int max_frames)
+    {
+        const int length = (int) ref_string_.size();
+
+        // histogram[d] counts the requests with stack distance d. Requests
+        // that are further away than max_frames fault for every reported
+        // frame count so they do not need to be counted separately
+        std::vector<int> histogram(max_frames + 1, 0);
+
+        // A 1 is stored at the time of the last request of every page
+        FenwickTree last_requests(length);
+        std::unordered_map<int, int> last_request_time;
+
+        for (int t = 0; t < length; ++t)
+        {
+            int page = ref_string_[t];
+            auto found = last_request_time.find(page);
+
+            if (found != last_request_time.end())
+            {
+                // Every page with a mark in [previous, t) was requested since
+                // the last time this page was, including the page itself
+                int previous = found->second;
+                int distance = last_requests.RangeSum(previous, t - 1);
+                if (distance <= max_frames)
+                {
+                    histogram[distance] += 1;
+                }
+
+                last_requests.Add(previous, -1);
+                found->second = t;
+            }
+            else
+            {
+                last_request_time[page] = t;
+            }
+
+            last_requests.Add(t, 1);
+        }
+
+        // Every request faults with zero frames and each extra frame turns
+        // the requests at that distance into hits
+        std::vector<int> curve(max_frames + 1);
+        int page_faults = length;
+        for (int f = 0; f <= max_frames; ++f)
+        {
+            page_faults -= histogram[f];
+            curve[f] = page_faults;
+        }
+
+        return curve;
+    }
+};
+
+/*!
+ * \brief The MissRatioCurve struct is an estimated LRU fault curve
+ */
+struct MissRatioCurve
+{
+    // Requests the curve was estimated from
+    uint64_t num_references;
+    // Requests that were sampled
+    uint64_t num_sampled;
+    // Share of the pages sampled at the end
+    double sampling_rate;
+    // page_faults[f] estimates the LRU page faults with f frames
+    std::vector<double> page_faults;
+    // The estimate at f frames is page_faults[f] +- error_bounds[f]
+    std::vector<double> error_bounds;
+};
+
+/*!
+ * \brief The SHARDSEstimator class estimates the LRU fault curve of a
+ * reference string from a sample of its pages, after the SHARDS algorithm of
+ * Waldspurger et al. A page is sampled when its hash is below a threshold,
+ * so every request of a sampled page is seen and the stack distances among
+ * the sampled pages, divided by the sampling rate, estimate the real ones.
+ *
+ * With a fixed rate the number of pages tracked grows with the footprint of
+ * the trace. With a maximum number of samples the threshold is lowered to
+ * the largest tracked hash whenever there are too many pages, the pages at
+ * that hash are dropped and the histogram is scaled down to the new rate,
+ * so memory stays constant however long the trace is.
+ *
+ * Stack distances come from a FenwickTree over the request times of the
+ * tracked pages, which is renumbered when it fills up, so every sampled
+ * request is O(log tracked pages) amortised and the rest are one hash.
+ */
+class SHARDSEstimator
+{
+public:
+    /*!
+     * \brief SHARDSEstimator constructs an estimator that has seen nothing
+     * \param sampling_rate Share of the pages to sample, in (0, 1]
+     * \param max_frames Largest number of frames to estimate the faults of
+     * \param max_samples Most pages to track, lowering the rate as needed,
+     * 0 keeps the rate fixed
+     */
+    SHARDSEstimator(double sampling_rate, int max_frames, int max_samples = 0)
+    {
+        sampling_rate = sampling_rate > 1.0 || !(sampling_rate > 0.0) ? 1.0 : sampling_rate;
+        initial_threshold_ = (uint64_t) (sampling_rate * (double) kModulus);
+        initial_threshold_ = initial_threshold_ == 0 ? 1 : initial_threshold_;
+        max_frames_ = max_frames < 0 ? 0 : max_frames;
+        max_samples_ = max_samples < 0 ? 0 : max_samples;
+        Reset();
+    }
+
+    /*!
+     * \brief Access records a request
+     */
+    void Access(int page)
+    {
+        num_references_ += 1;
+
+        uint64_t hash = HashPage(page) & (kModulus - 1);
+        if (hash >= threshold_)
+        {
+            return;
+        }
+        num_sampled_ += 1;
+
+        int time = time_of_.Find(page);
+        if (time >= 0)
+        {
+            // Distinct sampled pages requested since, including this one.
+            // The others are scaled up to all pages, the page itself is not.
+            int distance = requests_.RangeSum(time, next_time_ - 1);
+            double scaled = 1.0 + (double) (distance - 1) * (double) kModulus / (double) threshold_;
+            if (scaled <= (double) max_frames_)
+            {
+                histogram_[(size_t) (scaled + 0.5)] += 1.0;
+            }
+            else
+            {
+                beyond_ += 1.0;
+            }
+
+            requests_.Add(time, -1);
+            time_pages_[time] = kNoPage;
+        }
+        else
+        {
+            cold_ += 1.0;
+            num_tracked_ += 1;
+            if (max_samples_ > 0)
+            {
+                largest_hashes_.push(std::make_pair(hash, page));
+            }
+        }
+
+        if (next_time_ == (int) time_pages_.size())
+        {
+            Compact();
+        }
+        requests_.Add(next_time_, 1);
+        time_pages_[next_time_] = page;
+        time_of_.Set(page, next_time_);
+        next_time_ += 1;
+
+        if (max_samples_ > 0 && num_tracked_ > max_samples_)
+        {
+            LowerThreshold();
+        }
+    }
+
+    /*!
+     * \brief AccessMany records a batch of requests in order
+     */
+    void AccessMany(RefStringView pages)
+    {
+        for (auto i = pages.begin(); i != pages.end(); ++i)
+        {
+            Access(*i);
+        }
+    }
+
+    /*!
+     * \brief Reset forgets every request and restores the initial rate
+     */
+    void Reset()
+    {
+        threshold_ = initial_threshold_;
+        num_references_ = 0;
+        num_sampled_ = 0;
+        histogram_.assign(max_frames_ + 1, 0.0);
+        beyond_ = 0.0;
+        cold_ = 0.0;
+        time_of_.Clear();
+        largest_hashes_ = std::priority_queue<std::pair<uint64_t, int>>();
+        num_tracked_ = 0;
+        time_pages_.assign(kInitialTimes, kNoPage);
+        requests_ = FenwickTree(kInitialTimes);
+        next_time_ = 0;
+    }
+
+    /*!
+     * \brief Curve estimates the LRU faults for every frame count up to
+     * max_frames. The sampled histogram is first corrected so it holds as
+     * many requests as the rate says were sampled (SHARDS-adj); the error
+     * bound is the 95% binomial interval of every miss ratio taking each
+     * tracked page as one independent sample, which is on the safe side
+     * because a page's requests are sampled all together.
+     */
+    MissRatioCurve Curve() const
+    {
+        MissRatioCurve curve;
+        curve.num_references = num_references_;
+        curve.num_sampled = num_sampled_;
+        curve.sampling_rate = SamplingRate();
+        curve.page_faults.assign(max_frames_ + 1, 0.0);
+        curve.error_bounds.assign(max_frames_ + 1, 0.0);
+
+        double total = cold_ + beyond_;
+        for (double count : histogram_)
+        {
+            total += count;
+        }
+
+        // The requests the rate says should have been sampled but were not
+        // (or the other way round) go to the shortest distances
+        double adjustment = (double) num_references_ * SamplingRate() - total;
+        std::vector<double> histogram = histogram_;
+        if (max_frames_ >= 1)
+        {
+            histogram[1] += adjustment;
+        }
+        total += adjustment;
+
+        double misses = total;
+        for (int f = 0; f <= max_frames_; ++f)
+        {
+            misses -= histogram[f];
+            double ratio = total > 0.0 ? misses / total : 0.0;
+            ratio = ratio < 0.0 ? 0.0 : (ratio > 1.0 ? 1.0 : ratio);
+
+            curve.page_faults[f] = ratio * (double) num_references_;
+            if (num_tracked_ > 0)
+            {
+                curve.error_bounds[f] = 1.96 * std::sqrt(ratio * (1.0 - ratio) / (double) num_tracked_)
+                        * (double) num_references_;
+            }
+        }
+
+        return curve;
+    }
+
+    /*!
+     * \brief SamplingRate returns the share of the pages sampled right now
+     */
+    double SamplingRate() const { return (double) threshold_ / (double) kModulus; }
+    int MaxFrames() const { return max_frames_; }
+    int NumTracked() const { return num_tracked_; }
+
+private:
+    // Hashes are taken modulo this, the threshold is out of it
+    static const uint64_t kModulus = 1ull << 24;
+    // Room for request times at first, and the page of a time that is
+    // not the last request of its page
+    enum { kInitialTimes = 1024, kNoPage = -1 };
+
+    /*!
+     * \brief Compact renumbers the request times of the tracked pages from 0
+     * keeping their order, doubling the room for times when more than half
+     * of it is taken
+     */
+    void Compact()
+    {
+        size_t size = time_pages_.size();
+        if ((size_t) num_tracked_ * 2 > size)
+        {
+            size *= 2;
+        }
+
+        std::vector<int> pages;
+        pages.reserve(num_tracked_);
+        for (int time = 0; time < next_time_; ++time)
+        {
+            if (time_pages_[time] != kNoPage)
+            {
+                pages.push_back(time_pages_[time]);
+            }
+        }
+
+        time_pages_.assign(size, kNoPage);
+        requests_ = FenwickTree((int) size);
+        for (int time = 0; time < (int) pages.size(); ++time)
+        {
+            time_pages_[time] = pages[time];
+            time_of_.Set(pages[time], time);
+            requests_.Add(time, 1);
+        }
+        next_time_ = (int) pages.size();
+    }
+
+    /*!
+     * \brief LowerThreshold drops the pages with the largest tracked hash
+     * and lowers the rate to stop sampling them, scaling what was counted
+     * at the old rate down to the new one
+     */
+    void LowerThreshold()
+    {
+        uint64_t new_threshold = largest_hashes_.top().first;
+        while (!largest_hashes_.empty() && largest_hashes_.top().first == new_threshold)
+        {
+            int page = largest_hashes_.top().second;
+            largest_hashes_.pop();
+
+            int time = time_of_.Find(page);
+            requests_.Add(time, -1);
+            time_pages_[time] = kNoPage;
+            time_of_.Erase(page);
+            num_tracked_ -= 1;
+        }
+
+        double scale = (double) new_threshold / (double) threshold_;
+        for (double& count : histogram_)
+        {
+            count *= scale;
+        }
+        beyond_ *= scale;
+        cold_ *= scale;
+        threshold_ = new_threshold;
+    }
+
+    // Sampling threshold, a page is sampled when its hash is below it
+    uint64_t threshold_;
+    uint64_t initial_threshold_;
+    int max_frames_;
+    int max_samples_;
+
+    uint64_t num_references_;
+    uint64_t num_sampled_;
+    // histogram_[d] counts the sampled requests at scaled stack distance d,
+    // beyond_ the ones further than max_frames_ and cold_ the first requests
+    std::vector<double> histogram_;
+    double beyond_;
+    double cold_;
+
+    // Tracked page -> time of its last request
+    PageMap time_of_;
+    // Page requested at every time, kNoPage once it was requested again
+    std::vector<int> time_pages_;
+    // A 1 at the time of the last request of every tracked page
+    FenwickTree requests_;
+    int next_time_;
+    int num_tracked_;
+    // Hashes of the tracked pages, largest first, with a fixed sample size
+    std::priority_queue<std::pair<uint64_t, int>> largest_hashes_;
+};
+
+/*!
+ * \brief The SHARDSPageReplacement class estimates the number of page faults
+ * in a system using the LRU algorithm from a sample of the pages. See
+ * SHARDSEstimator. It gives the same answers as LRUStackDistance with a
+ * sampling rate of 1 and a small fraction of its work and memory otherwise.
+ */
+class SHARDSPageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief SHARDSPageReplacement constructs a SHARDSPageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system
+     * \param sampling_rate Share of the pages to sample, in (0, 1]
+     * \param max_samples Most pages to track, 0 keeps the rate fixed
+     */
+    SHARDSPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames,
+                          double sampling_rate = 0.01, int max_samples = 0)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames),
+      sampling_rate_(sampling_rate), max_samples_(max_samples) {}
+
+    SHARDSPageReplacement(RefStringView ref_string, int num_pages, int num_frames,
+                          double sampling_rate = 0.01, int max_samples = 0)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames),
+      sampling_rate_(sampling_rate), max_samples_(max_samples) {}
+
+    /*!
+     * \brief CalculatePageFaults estimates the number of LRU page faults
+     * with num_frames frames
+     * \return The estimated number of page faults, rounded
+     */
+    int CalculatePageFaults()
+    {
+        int frames = num_frames_ < 0 ? 0 : num_frames_;
+        return (int) (CalculateFaultCurve(frames).page_faults[frames] + 0.5);
+    }
+
+    /*!
+     * \brief CalculateFaultCurve estimates the LRU miss curve in a single
+     * pass over the reference string
+     * \param max_frames Largest number of frames to report
+     * \return The estimated faults and their error bounds for every frame
+     * count from 0 to max_frames
+     */
+    MissRatioCurve CalculateFaultCurve(int max_frames)
+    {
+        SHARDSEstimator estimator(sampling_rate_, max_frames, max_samples_);
+        estimator.AccessMany(ref_string_);
+        return estimator.Curve();
+    }
+
+private:
+    double sampling_rate_;
+    int max_samples_;
+};
+
+class OPTPageReplacement: public AbstractPageReplacement
+{
+public:
+	OPTPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames) 
+	:AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    OPTPageReplacement(RefStringView ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    int CalculatePageFaults()
+	{
+		// Initialize a vector to store the memory_requests
+        std::vector <int> current_pages;
+
+		// Start the page_fault count
+		int page_faults = 0;
+
+        // With no frames every single request is a page fault. The capacity
+        // checks below never see a full memory in that case.
+        if (num_frames_ <= 0)
+        {
+            return (int) ref_string_.size();
+        }
+
+        for (auto i = ref_string_.begin(); i != ref_string_.end(); ++i)
+		{
+            // If the memory_requests is at maximum capacity AND it cannot be found then
+            // we have to shift the memory around. However if either one of those is false
+            // then we can just add it to the memory
+            if (current_pages.size() == (size_t) num_frames_ &&
+                !FindInContainer<std::vector<int>>(*i, current_pages))
+            {
+                // If the page that is being requested is not currently in memory
+                // then we need to find the page currently in memory that is furthest
+                // away from being requested again. We accomplish this using a vector
+                // with some extra fluff around accessing but this could be easily
+                // abstracted away to another class
+                //      1. An object within the set cannot be added again
+                //      2. The set will remain ordered
+                // These are both integral to how we are going to use the data structure.
+                // Conceptually we are using the set like a unique stack. Meaning that we append
+                // a value onto the top only if that element is not already in the stack. Then we can
+                // remove the page from the top of the stack (or any page that hasn't shown up
+                // in the stack if the stack's length is less than the frame length.
+
+                // Initialize the unique stack
+                std::vector<int> uniqueMemoryStack;
+
+                // Loop through the rest of the memory adding each element to the stack
+                // if it is currently in memory.
+                for (auto j = i; j != ref_string_.end(); j++)
+                {
+                    // If the memory request isn't currently in memory then just continue
+                    if(!FindInContainer<std::vector<int>>(*j, current_pages))
+                    {
+                        continue;
+                    }
+
+                    // If the memory request is in memory then add it to the unique stack
+                    if(!FindInContainer<std::vector<int>>(*j, uniqueMemoryStack))
+                    {
+                        uniqueMemoryStack.push_back(*j);
+                    }
+                }
+
+                // Now there are two cases that we have to check to find the memory frame
+                // that is the furthest away from being used. If the size of the stack
+                // is equal to the number of frames then every page in memory is used again
+                // so we can just pop the top of the stack and remove that item from the array
+                if (uniqueMemoryStack.size() == (size_t) num_frames_)
+                {
+                    // remove *uniqueMemoryStack.rbegin();
+                    for (auto j = current_pages.begin(); j != current_pages.end(); j++)
+                    {
+                        if (*j == *uniqueMemoryStack.rbegin())
+                        {
+                            current_pages.erase(j);
+                            break;
+                        }
+                    }
+                }
+                // If the length of the memory stack isnt equal to the number of pages then
+                // there exists a page in memory that isn't used in the rest of the running
+                // of the program. It makes sense to check and remove all elements that do
+                // not show up in this list. However even if we do that it will still cause
+                // a page fault when we try to access memory that isn't in the current pages
+                // To remove everything that isn't in the stack we iterate through the stack
+                // and replace every entry in the current pages with the entries in the stack
+                else
+                {
+                    for (auto j = current_pages.begin(); j != current_pages.end(); j++)
+                    {
+                        // If the page was not found in the memory stack then remove it
+                        if (!FindInContainer<std::vector<int>>(*j, uniqueMemoryStack))
+                        {
+                            current_pages.erase(j);
+                            break;
+                        }
+                    }
+                }
+
+
+                current_pages.push_back(*i);
+                page_faults += 1;
+            }
+
+            // If the current pages in memory is not equal to the maximum number of pages that
+            // can be contained in memory then the it is a page fault but it is handled differently
+            // We can just add to the page fault count and push the page into memory. If this
+            // algorithm was going to be used in a prod setting then these would be factored
+            // out so that the conditions were only checked once but I am leaving them here
+            // for readability.
+            else if (current_pages.size() != (size_t) num_frames_ &&
+                     !FindInContainer<std::vector<int>>(*i, current_pages))
+            {
+                page_faults += 1;
+                current_pages.push_back(*i);
+            }
+		}
+
+		return page_faults;
+	}
+};
+
+/*!
+ * \brief The HeapOPTPageReplacement class calculates the same page faults as
+ * OPTPageReplacement in O(n log frames). Instead of scanning the rest of the
+ * reference string on every fault, the index of the next request of every
+ * position is computed once in a backwards pass. The resident pages are kept
+ * in a max heap keyed by their next request so the page that is needed
+ * furthest in the future is always on top.
+ */
+class HeapOPTPageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief HeapOPTPageReplacement constructs a HeapOPTPageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system
+     */
+    HeapOPTPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    HeapOPTPageReplacement(RefStringView ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of page faults using
+     * the OPT algorithm. This algorithm swaps out the page in main memory that
+     * will not be requested for the longest time.
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        const int length = (int) ref_string_.size();
+
+        // With no frames every single request is a page fault
+        if (num_frames_ <= 0)
+        {
+            return length;
+        }
+
+        // Position of the next request of the same page for every position,
+        // or length if the page is never requested again
+        std::vector<int> next_request = NextRequests();
+
+        // Resident page -> position of its next request. The heap holds
+        // (next request, page) pairs for the resident pages
+        std::unordered_map<int, int> resident;
+        resident.reserve(num_frames_ * 2);
+        std::priority_queue<std::pair<int, int>> furthest;
+
+        int page_faults = 0;
+
+        for (int t = 0; t < length; ++t)
+        {
+            int page = ref_string_[t];
+            auto found = resident.find(page);
+
+            // A hit leaves an outdated entry keyed by t in the heap. Current
+            // entries are always keyed after t, so outdated ones can never
+            // reach the top while a page is resident and are dropped lazily
+            // when the heap is compacted below
+            if (found != resident.end())
+            {
+                found->second = next_request[t];
+                furthest.push(std::make_pair(next_request[t], page));
+
+                if (furthest.size() > resident.size() * 2 + 16)
+                {
+                    CompactHeap(furthest, resident);
+                }
+                continue;
+            }
+
+            page_faults += 1;
+
+            // Evict the page that is requested furthest in the future
+            if (resident.size() == (size_t) num_frames_)
+            {
+                resident.erase(furthest.top().second);
+                furthest.pop();
+            }
+
+            resident[page] = next_request[t];
+            furthest.push(std::make_pair(next_request[t], page));
+        }
+
+        return page_faults;
+    }
+
+    /*!
+     * \brief NextRequests finds for every position of the reference string
+     * the position at which the same page is requested next.
+     * \return A vector with the next positions, or the reference string
+     * length for the last request of a page
+     */
+    std::vector<int> NextRequests() const
+    {
+        const int length = (int) ref_string_.size();
+        std::vector<int> next_request(length);
+        std::unordered_map<int, int> seen;
+
+        // Walk backwards remembering the latest position of every page
+        for (int t = length - 1; t >= 0; --t)
+        {
+            auto found = seen.find(ref_string_[t]);
+            if (found != seen.end())
+            {
+                next_request[t] = found->second;
+                found->second = t;
+            }
+            else
+            {
+                next_request[t] = length;
+                seen[ref_string_[t]] = t;
+            }
+        }
+
+        return next_request;
+    }
+
+private:
+    /*!
+     * \brief CompactHeap rebuilds the heap from the resident pages, dropping
+     * every outdated entry. This bounds the heap to O(frames) entries.
+     */
+    static void CompactHeap(std::priority_queue<std::pair<int, int>>& furthest,
+                            const std::unordered_map<int, int>& resident)
+    {
+        std::vector<std::pair<int, int>> entries;
+        entries.reserve(resident.size());
+        for (auto i = resident.begin(); i != resident.end(); ++i)
+        {
+            entries.push_back(std::make_pair(i->second, i->first));
+        }
+
+        furthest = std::priority_queue<std::pair<int, int>>(
+                    std::less<std::pair<int, int>>(), std::move(entries));
+    }
+};
+
+/*!
+ * \brief The ClockPageCache class is the CLOCK (second chance) algorithm as an
+ * online cache. The frames form a circle with a hand pointing at the oldest
+ * page. Every frame has a reference bit that is set when its page is hit. On
+ * a fault the hand sweeps forward, clearing set bits and giving those pages a
+ * second chance, and evicts the first page whose bit is already clear. A page
+ * that is swapped in starts with its bit clear, so it only survives a sweep
+ * once it has been requested again.
+ *
+ * The pages and the reference bits are flat arrays, the bits packed 64 to a
+ * word so the hand can clear and skip a whole word of referenced frames at a
+ * time. Hits only set a bit, which is why real kernels approximate LRU this
+ * way.
+ */
+class ClockPageCache
+{
+public:
+    /*!
+     * \brief ClockPageCache constructs an empty cache
+     * \param num_frames Number of frames in the system
+     * \param dense_pages Pages below this are looked up in an array, pass 0
+     * when the page ids are not bounded
+     */
+    explicit ClockPageCache(int num_frames, int dense_pages = 0)
+        : frame_of_(dense_pages)
+    {
+        num_frames_ = num_frames < 0 ? 0 : num_frames;
+        frame_pages_.assign(num_frames_, 0);
+        referenced_.assign((num_frames_ + 63) / 64, 0);
+        frame_of_.Reserve(dense_pages > 0 ? 0 : num_frames_ * 2);
+        Reset();
+    }
+
+    /*!
+     * \brief Access requests a page, swapping it in if it is not in memory
+     * \param page Requested page
+     * \return Whether the request hit and which page was swapped out, if any
+     */
+    PageAccessResult Access(int page)
+    {
+        PageAccessResult result = {true, false, 0};
+        int frame = frame_of_.Find(page);
+
+        // A hit only has to mark the frame as referenced
+        if (frame >= 0)
+        {
+            referenced_[frame >> 6] |= 1ull << (frame & 63);
+            return result;
+        }
+
+        result.hit = false;
+        if (num_frames_ == 0)
+        {
+            return result;
+        }
+
+        // Fill the free frames first, the hand stays on frame 0 which holds
+        // the oldest page once memory is full
+        if (size_ < num_frames_)
+        {
+            frame = size_++;
+        }
+        else
+        {
+            frame = SweepHand();
+            result.evicted = true;
+            result.evicted_page = frame_pages_[frame];
+            frame_of_.Erase(result.evicted_page);
+            hand_ = frame + 1 == num_frames_ ? 0 : frame + 1;
+        }
+
+        frame_pages_[frame] = page;
+        frame_of_.Set(page, frame);
+        return result;
+    }
+
+    /*!
+     * \brief AccessMany requests a batch of pages in order
+     * \param pages Requested pages
+     * \return The number of page faults in the batch
+     */
+    int AccessMany(RefStringView pages)
+    {
+        int page_faults = 0;
+        for (auto i = pages.begin(); i != pages.end(); ++i)
+        {
+            page_faults += !Access(*i).hit;
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Reset swaps every page out
+     */
+    void Reset()
+    {
+        frame_of_.Clear();
+        std::fill(referenced_.begin(), referenced_.end(), 0);
+        hand_ = 0;
+        size_ = 0;
+    }
+
+    int NumFrames() const { return num_frames_; }
+    int Size() const { return size_; }
+    bool Contains(int page) const { return frame_of_.Find(page) >= 0; }
+
+private:
+    /*!
+     * \brief SweepHand moves the hand to the first frame with a clear
+     * reference bit, clearing every set bit it passes
+     * \return The frame to evict
+     */
+    int SweepHand()
+    {
+        for (;;)
+        {
+            int word = hand_ >> 6;
+            int bit = hand_ & 63;
+
+            // Frames from the hand to the end of this word, but not past the
+            // last frame
+            int last = std::min(64, num_frames_ - (word << 6));
+            uint64_t frames = (last == 64 ? ~0ull : (1ull << last) - 1) & (~0ull << bit);
+            uint64_t unreferenced = ~referenced_[word] & frames;
+
+            if (unreferenced)
+            {
+                // Every frame before the victim gets its second chance
+                int victim = CountTrailingZeros(unreferenced);
+                referenced_[word] &= ~(frames & ((1ull << victim) - 1));
+                return (word << 6) + victim;
+            }
+
+            // Every frame left in this word was referenced
+            referenced_[word] &= ~frames;
+            hand_ = (word << 6) + last;
+            hand_ = hand_ >= num_frames_ ? 0 : hand_;
+        }
+    }
+
+    // Number of frames in the system
+    int num_frames_;
+    // Page held in every frame
+    std::vector<int> frame_pages_;
+    // Reference bit of every frame, 64 to a word
+    std::vector<uint64_t> referenced_;
+    // Resident page -> frame it is held in
+    PageMap frame_of_;
+    // Frame the hand points at
+    int hand_;
+    // Number of frames in use
+    int size_;
+};
+
+/*!
+ * \brief The ClockPageReplacement class is used to calculate the number of
+ * page faults in a system using the CLOCK (second chance) approximation of
+ * LRU. See ClockPageCache.
+ */
+class ClockPageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief ClockPageReplacement constructs a ClockPageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system
+     */
+    ClockPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    ClockPageReplacement(RefStringView ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of page faults using
+     * the CLOCK algorithm
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        ClockPageCache cache(num_frames_, PageSet::DensePagesFor(ref_string_));
+        return cache.AccessMany(ref_string_);
+    }
+};
+
+/*!
+ * \brief The ARCPageCache class is the Adaptive Replacement Cache of Megiddo
+ * and Modha as an online cache. Resident pages are split between T1 (pages
+ * requested once recently) and T2 (pages requested at least twice). Ghost
+ * lists B1 and B2 remember the pages recently evicted from T1 and T2. A hit
+ * in a ghost list shows which side would have benefited from more frames and
+ * moves the target size p of T1 towards it. Because a scan only ever passes
+ * through T1 it cannot flush the frequently used pages out of T2.
+ *
+ * All four lists share one IndexedList node pool of 2 * frames nodes and a
+ * PageMap finds the node of a page, so every request is O(1).
+ */
+class ARCPageCache
+{
+public:
+    /*!
+     * \brief ARCPageCache constructs an empty cache
+     * \param num_frames Number of frames in the system
+     * \param dense_pages Pages below this are looked up in an array, pass 0
+     * when the page ids are not bounded
+     */
+    explicit ARCPageCache(int num_frames, int dense_pages = 0)
+        : node_of_(dense_pages)
+    {
+        num_frames_ = num_frames < 0 ? 0 : num_frames;
+        node_pages_.assign(2 * num_frames_, 0);
+        node_of_.Reserve(dense_pages > 0 ? 0 : num_frames_ * 4);
+        Reset();
+    }
+
+    /*!
+     * \brief Access requests a page, swapping it in if it is not in memory
+     * \param page Requested page
+     * \return Whether the request hit and which page was swapped out, if any
+     */
+    PageAccessResult Access(int page)
+    {
+        PageAccessResult result = {true, false, 0};
+        int node = node_of_.Find(page);
+        int list = node >= 0 ? lists_.ListOf(node) : -1;
+
+        // Case I: a hit in T1 or T2 makes the page frequently used
+        if (list == kT1 || list == kT2)
+        {
+            lists_.MoveToBack(kT2, node);
+            return result;
+        }
+
+        result.hit = false;
+        if (num_frames_ == 0)
+        {
+            return result;
+        }
+
+        // Case II and III: a ghost hit adapts the target size of T1 and the
+        // page goes straight to T2 because it has now been requested twice
+        if (list == kB1 || list == kB2)
+        {
+            int b1 = lists_.Size(kB1);
+            int b2 = lists_.Size(kB2);
+            if (list == kB1)
+            {
+                target_t1_ = std::min(num_frames_, target_t1_ + std::max(b2 / b1, 1));
+            }
+            else
+            {
+                target_t1_ = std::max(0, target_t1_ - std::max(b1 / b2, 1));
+            }
+
+            Replace(list == kB2, result);
+            lists_.MoveToBack(kT2, node);
+            return result;
+        }
+
+        // Case IV: a page that is not in any list
+        int t1 = lists_.Size(kT1);
+        int l1 = t1 + lists_.Size(kB1);
+        int total = l1 + lists_.Size(kT2) + lists_.Size(kB2);
+
+        if (l1 == num_frames_)
+        {
+            if (t1 < num_frames_)
+            {
+                Forget(lists_.Front(kB1));
+                Replace(false, result);
+            }
+            else
+            {
+                // T1 fills every frame and B1 is empty, so the least recently
+                // used page of T1 is dropped without becoming a ghost
+                int victim = lists_.Front(kT1);
+                result.evicted = true;
+                result.evicted_page = node_pages_[victim];
+                Forget(victim);
+            }
+        }
+        else if (total >= num_frames_)
+        {
+            if (total == 2 * num_frames_)
+            {
+                Forget(lists_.Front(kB2));
+            }
+            Replace(false, result);
+        }
+
+        node = free_nodes_.back();
+        free_nodes_.pop_back();
+        node_pages_[node] = page;
+        node_of_.Set(page, node);
+        lists_.PushBack(kT1, node);
+        return result;
+    }
+
+    /*!
+     * \brief AccessMany requests a batch of pages in order
+     * \param pages Requested pages
+     * \return The number of page faults in the batch
+     */
+    int AccessMany(RefStringView pages)
+    {
+        int page_faults = 0;
+        for (auto i = pages.begin(); i != pages.end(); ++i)
+        {
+            page_faults += !Access(*i).hit;
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Reset swaps every page out and forgets every ghost
+     */
+    void Reset()
+    {
+        lists_.Reset(2 * num_frames_, 4);
+        node_of_.Clear();
+        free_nodes_.clear();
+        for (int node = 2 * num_frames_ - 1; node >= 0; --node)
+        {
+            free_nodes_.push_back(node);
+        }
+        target_t1_ = 0;
+    }
+
+    int NumFrames() const { return num_frames_; }
+    int Size() const { return lists_.Size(kT1) + lists_.Size(kT2); }
+    bool Contains(int page) const
+    {
+        int node = node_of_.Find(page);
+        return node >= 0 && (lists_.ListOf(node) == kT1 || lists_.ListOf(node) == kT2);
+    }
+
+    /*!
+     * \brief TargetT1 returns the current target size of T1, which shows how
+     * far the cache has adapted towards recency (large) or frequency (small)
+     */
+    int TargetT1() const { return target_t1_; }
+
+private:
+    // Lists in the IndexedList
+    static const int kT1 = 0;
+    static const int kT2 = 1;
+    static const int kB1 = 2;
+    static const int kB2 = 3;
+
+    /*!
+     * \brief Replace evicts the least recently used page of T1 or T2 into its
+     * ghost list, picking T1 when it is over its target size. Does nothing
+     * while there are free frames.
+     * \param in_b2 True when the requested page was found in B2
+     */
+    void Replace(bool in_b2, PageAccessResult& result)
+    {
+        int t1 = lists_.Size(kT1);
+        if (t1 + lists_.Size(kT2) < num_frames_)
+        {
+            return;
+        }
+
+        int victim;
+        if (t1 >= 1 && ((in_b2 && t1 == target_t1_) || t1 > target_t1_))
+        {
+            victim = lists_.Front(kT1);
+            lists_.MoveToBack(kB1, victim);
+        }
+        else
+        {
+            victim = lists_.Front(kT2);
+            lists_.MoveToBack(kB2, victim);
+        }
+
+        result.evicted = true;
+        result.evicted_page = node_pages_[victim];
+    }
+
+    /*!
+     * \brief Forget removes a node from the lists altogether
+     */
+    void Forget(int node)
+    {
+        lists_.Remove(node);
+        node_of_.Erase(node_pages_[node]);
+        free_nodes_.push_back(node);
+    }
+
+    // Number of frames in the system
+    int num_frames_;
+    // T1, T2, B1 and B2, from least to most recently used
+    IndexedList lists_;
+    // Page of every node
+    std::vector<int> node_pages_;
+    // Nodes that are in none of the lists
+    std::vector<int> free_nodes_;
+    // Page -> node for every page in any of the lists
+    PageMap node_of_;
+    // Target size of T1
+    int target_t1_;
+};
+
+/*!
+ * \brief The ARCPageReplacement class is used to calculate the number of page
+ * faults in a system using the Adaptive Replacement Cache. See ARCPageCache.
+ */
+class ARCPageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief ARCPageReplacement constructs a ARCPageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system
+     */
+    ARCPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    ARCPageReplacement(RefStringView ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of page faults using
+     * the ARC algorithm
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        ARCPageCache cache(num_frames_, PageSet::DensePagesFor(ref_string_));
+        return cache.AccessMany(ref_string_);
+    }
+};
+
+/*!
+ * \brief The LIRSPageCache class is the Low Inter-reference Recency Set
+ * algorithm of Jiang and Zhang as an online cache. Pages are ranked by the
+ * recency of their last two requests instead of only the last one. Most
+ * frames hold LIR pages, the pages that were requested twice within a short
+ * distance, and a small share (1%, at least one frame) holds HIR pages that
+ * are only passing through. A page that is requested once, like every page
+ * of a loop larger than memory, never gets to push out an LIR page, so loops
+ * and scans no longer flush the cache the way they do with LRU.
+ *
+ * The stack S holds the LIR pages and the HIR pages (resident or not) that
+ * were requested more recently than the oldest LIR page, and is pruned so
+ * its bottom is always an LIR page. The queue Q holds the resident HIR pages
+ * in eviction order. Both are IndexedLists over one node pool, so every
+ * request is O(1) amortised. The non-resident HIR pages kept in S are capped
+ * at twice the number of frames; past that the longest evicted one is
+ * forgotten, which bounds the metadata on arbitrarily long traces.
+ */
+class LIRSPageCache
+{
+public:
+    /*!
+     * \brief LIRSPageCache constructs an empty cache
+     * \param num_frames Number of frames in the system
+     * \param dense_pages Pages below this are looked up in an array, pass 0
+     * when the page ids are not bounded
+     */
+    explicit LIRSPageCache(int num_frames, int dense_pages = 0)
+        : node_of_(dense_pages)
+    {
+        num_frames_ = num_frames < 0 ? 0 : num_frames;
+
+        // A hundredth of the frames for HIR pages but always one, and always
+        // at least one LIR frame once there is more than one frame
+        int max_hir = std::max(1, num_frames_ / 100);
+        if (num_frames_ >= 2)
+        {
+            max_hir = std::min(max_hir, num_frames_ - 1);
+        }
+        max_lir_ = std::max(0, num_frames_ - max_hir);
+        max_ghosts_ = 2 * num_frames_;
+
+        const int num_nodes = num_frames_ + max_ghosts_ + 1;
+        node_pages_.assign(num_nodes, 0);
+        status_.assign(num_nodes, 0);
+        node_of_.Reserve(dense_pages > 0 ? 0 : num_nodes * 2);
+        Reset();
+    }
+
+    /*!
+     * \brief Access requests a page, swapping it in if it is not in memory
+     * \param page Requested page
+     * \return Whether the request hit and which page was swapped out, if any
+     */
+    PageAccessResult Access(int page)
+    {
+        PageAccessResult result = {true, false, 0};
+        int node = node_of_.Find(page);
+
+        if (node >= 0 && status_[node] == kLIR)
+        {
+            // The page stays LIR and goes to the top of the stack. If it was
+            // the bottom the stack has to be pruned down to the next LIR page
+            bool was_bottom = stack_.Front(0) == node;
+            stack_.MoveToBack(0, node);
+            if (was_bottom)
+            {
+                Prune();
+            }
+            return result;
+        }
+
+        if (node >= 0 && status_[node] == kHIR)
+        {
+            if (InStack(node))
+            {
+                // Requested again while still in the stack, so its inter
+                // reference recency beats the oldest LIR page, they swap
+                queues_.Remove(node);
+                Promote(node);
+            }
+            else
+            {
+                stack_.PushBack(0, node);
+                queues_.MoveToBack(kQueue, node);
+            }
+            return result;
+        }
+
+        result.hit = false;
+        if (num_frames_ == 0)
+        {
+            return result;
+        }
+
+        // Make room by evicting the oldest resident HIR page. While the LIR
+        // set is still filling up there is always a free frame.
+        if (lir_count_ + queues_.Size(kQueue) == num_frames_)
+        {
+            int victim = queues_.Front(kQueue);
+            result.evicted = true;
+            result.evicted_page = node_pages_[victim];
+
+            if (InStack(victim))
+            {
+                status_[victim] = kGhost;
+                queues_.MoveToBack(kGhosts, victim);
+                if (queues_.Size(kGhosts) > max_ghosts_)
+                {
+                    int oldest = queues_.Front(kGhosts);
+                    queues_.Remove(oldest);
+                    stack_.Remove(oldest);
+                    Forget(oldest);
+                }
+            }
+            else
+            {
+                queues_.Remove(victim);
+                Forget(victim);
+            }
+        }
+
+        // The ghost may have just been forgotten to make room
+        node = node_of_.Find(page);
+
+        if (lir_count_ < max_lir_ && node < 0)
+        {
+            // Until the LIR set is full every new page is LIR
+            node = Allocate(page);
+            status_[node] = kLIR;
+            lir_count_ += 1;
+            stack_.PushBack(0, node);
+        }
+        else if (node >= 0 && max_lir_ > 0)
+        {
+            // A ghost that is still in the stack was requested again soon
+            // enough to become LIR
+            queues_.Remove(node);
+            Promote(node);
+        }
+        else
+        {
+            // A new page starts as a resident HIR page
+            if (node < 0)
+            {
+                node = Allocate(page);
+            }
+            else
+            {
+                queues_.Remove(node);
+                stack_.Remove(node);
+            }
+            status_[node] = kHIR;
+            stack_.PushBack(0, node);
+            queues_.PushBack(kQueue, node);
+            Prune();
+        }
+
+        return result;
+    }
+
+    /*!
+     * \brief AccessMany requests a batch of pages in order
+     * \param pages Requested pages
+     * \return The number of page faults in the batch
+     */
+    int AccessMany(RefStringView pages)
+    {
+        int page_faults = 0;
+        for (auto i = pages.begin(); i != pages.end(); ++i)
+        {
+            page_faults += !Access(*i).hit;
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Reset swaps every page out and forgets every ghost
+     */
+    void Reset()
+    {
+        const int num_nodes = (int) node_pages_.size();
+        stack_.Reset(num_nodes, 1);
+        queues_.Reset(num_nodes, 2);
+        node_of_.Clear();
+        free_nodes_.clear();
+        for (int node = num_nodes - 1; node >= 0; --node)
+        {
+            free_nodes_.push_back(node);
+        }
+        lir_count_ = 0;
+    }
+
+    int NumFrames() const { return num_frames_; }
+    int Size() const { return lir_count_ + queues_.Size(kQueue); }
+    bool Contains(int page) const
+    {
+        int node = node_of_.Find(page);
+        return node >= 0 && status_[node] != kGhost;
+    }
+
+private:
+    // Status of a node
+    static const int kLIR = 0;
+    static const int kHIR = 1;
+    static const int kGhost = 2;
+
+    // Lists in queues_
+    static const int kQueue = 0;
+    static const int kGhosts = 1;
+
+    bool InStack(int node) const { return stack_.ListOf(node) == 0; }
+
+    /*!
+     * \brief Promote turns a node into an LIR page on top of the stack and
+     * demotes the LIR page at the bottom of the stack to the end of Q
+     */
+    void Promote(int node)
+    {
+        status_[node] = kLIR;
+        stack_.MoveToBack(0, node);
+
+        int bottom = stack_.Front(0);
+        stack_.Remove(bottom);
+        status_[bottom] = kHIR;
+        queues_.PushBack(kQueue, bottom);
+        Prune();
+    }
+
+    /*!
+     * \brief Prune pops HIR pages off the bottom of the stack until an LIR
+     * page is at the bottom. Resident ones stay in Q, ghosts are forgotten.
+     */
+    void Prune()
+    {
+        while (!stack_.Empty(0) && status_[stack_.Front(0)] != kLIR)
+        {
+            int bottom = stack_.Front(0);
+            stack_.Remove(bottom);
+            if (status_[bottom] == kGhost)
+            {
+                queues_.Remove(bottom);
+                Forget(bottom);
+            }
+        }
+    }
+
+    int Allocate(int page)
+    {
+        int node = free_nodes_.back();
+        free_nodes_.pop_back();
+        node_pages_[node] = page;
+        node_of_.Set(page, node);
+        return node;
+    }
+
+    /*!
+     * \brief Forget returns a node that is in no list to the free nodes
+     */
+    void Forget(int node)
+    {
+        node_of_.Erase(node_pages_[node]);
+        free_nodes_.push_back(node);
+    }
+
+    // Number of frames in the system
+    int num_frames_;
+    // Frames for LIR pages, the rest hold resident HIR pages
+    int max_lir_;
+    // Most non-resident HIR pages kept in the stack
+    int max_ghosts_;
+    // Number of LIR pages
+    int lir_count_;
+    // The stack S from bottom (front) to top (back)
+    IndexedList stack_;
+    // The queue Q of resident HIR pages, and the non-resident HIR pages in
+    // the stack in the order they were evicted
+    IndexedList queues_;
+    // Page and status of every node
+    std::vector<int> node_pages_;
+    std::vector<int> status_;
+    // Nodes that are not in use
+    std::vector<int> free_nodes_;
+    // Page -> node for every page the cache knows about
+    PageMap node_of_;
+};
+
+/*!
+ * \brief The LIRSPageReplacement class is used to calculate the number of page
+ * faults in a system using the LIRS algorithm. See LIRSPageCache.
+ */
+class LIRSPageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief LIRSPageReplacement constructs a LIRSPageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system
+     */
+    LIRSPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    LIRSPageReplacement(RefStringView ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of page faults using
+     * the LIRS algorithm
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        LIRSPageCache cache(num_frames_, PageSet::DensePagesFor(ref_string_));
+        return cache.AccessMany(ref_string_);
+    }
+};
+
+/*!
+ * \brief The FrequencySketch class estimates how often every page was
+ * requested recently in constant memory. It is a Count-Min sketch of four
+ * rows of 4-bit counters, sixteen to a word, behind a doorkeeper Bloom
+ * filter. The first request of a page only sets its doorkeeper bits, so
+ * the many pages that are requested once never reach the counters. Once
+ * the number of recorded requests reaches the sample size every counter is
+ * halved and the doorkeeper is cleared, so old popularity fades away.
+ */
+class FrequencySketch
+{
+public:
+    /*!
+     * \brief FrequencySketch constructs an empty sketch
+     * \param num_pages Number of pages the sketch should tell apart,
+     * usually the number of frames
+     */
+    explicit FrequencySketch(int num_pages)
+    {
+        if (num_pages < 1)
+        {
+            num_pages = 1;
+        }
+
+        // Four counters per page in every row and eight doorkeeper bits per
+        // page keep the collisions low. Both are powers of two so indexing
+        // is a mask.
+        row_mask_ = NextPowerOfTwo(4 * (uint64_t) num_pages, 64) - 1;
+        doorkeeper_mask_ = NextPowerOfTwo(8 * (uint64_t) num_pages, 64) - 1;
+        counters_.assign(kRows * ((row_mask_ + 1) / 16), 0);
+        doorkeeper_.assign((doorkeeper_mask_ + 1) / 64, 0);
+        sample_size_ = 10 * (uint64_t) num_pages;
+        additions_ = 0;
+    }
+
+    /*!
+     * \brief Increment records a request of a page
+     */
+    void Increment(int page)
+    {
+        uint64_t hash = HashPage(page);
+        if (!TestAndSetDoorkeeper(hash))
+        {
+            for (int row = 0; row < kRows; ++row)
+            {
+                uint64_t& word = counters_[CounterWord(hash, row)];
+                int shift = CounterShift(hash, row);
+                if (((word >> shift) & 15) != 15)
+                {
+                    word += 1ull << shift;
+                }
+            }
+        }
+
+        if (++additions_ >= sample_size_)
+        {
+            Age();
+        }
+    }
+
+    /*!
+     * \brief Estimate returns how often a page was requested recently. It
+     * never underestimates, it may overestimate when pages collide in
+     * every row.
+     */
+    int Estimate(int page) const
+    {
+        uint64_t hash = HashPage(page);
+        int estimate = 15;
+        for (int row = 0; row < kRows; ++row)
+        {
+            int count = (int) ((counters_[CounterWord(hash, row)] >> CounterShift(hash, row)) & 15);
+            estimate = count < estimate ? count : estimate;
+        }
+        return estimate + (InDoorkeeper(hash) ? 1 : 0);
+    }
+
+    /*!
+     * \brief Clear forgets every request
+     */
+    void Clear()
+    {
+        std::fill(counters_.begin(), counters_.end(), 0);
+        std::fill(doorkeeper_.begin(), doorkeeper_.end(), 0);
+        additions_ = 0;
+    }
+
+private:
+    static const int kRows = 4;
+
+    static uint64_t NextPowerOfTwo(uint64_t value, uint64_t minimum)
+    {
+        uint64_t power = minimum;
+        while (power < value)
+        {
+            power <<= 1;
+        }
+        return power;
+    }
+
+    /*!
+     * \brief CounterIndex picks the counter of a row by double hashing the
+     * two halves of the hash
+     */
+    uint64_t CounterIndex(uint64_t hash, int row) const
+    {
+        return ((hash & 0xffffffffull) + (uint64_t) row * ((hash >> 32) | 1)) & row_mask_;
+    }
+
+    size_t CounterWord(uint64_t hash, int row) const
+    {
+        return (size_t) (row * ((row_mask_ + 1) / 16) + (CounterIndex(hash, row) >> 4));
+    }
+
+    int CounterShift(uint64_t hash, int row) const
+    {
+        return (int) (CounterIndex(hash, row) & 15) * 4;
+    }
+
+    // The doorkeeper uses two bits per page. Each probe is all 64 bits of a
+    // mix of the hash, rotated so its best mixed high bits come first.
+    uint64_t DoorkeeperBit(uint64_t hash, int k) const
+    {
+        uint64_t mixed = k == 0 ? hash : hash * 0x9E3779B97F4A7C15ull;
+        return ((mixed >> 32) | (mixed << 32)) & doorkeeper_mask_;
+    }
+
+    bool InDoorkeeper(uint64_t hash) const
+    {
+        for (int k = 0; k < 2; ++k)
+        {
+            uint64_t bit = DoorkeeperBit(hash, k);
+            if (!((doorkeeper_[bit >> 6] >> (bit & 63)) & 1))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*!
+     * \brief TestAndSetDoorkeeper sets the doorkeeper bits of a hash
+     * \return Whether they were all set already
+     */
+    bool TestAndSetDoorkeeper(uint64_t hash)
+    {
+        bool present = true;
+        for (int k = 0; k < 2; ++k)
+        {
+            uint64_t bit = DoorkeeperBit(hash, k);
+            uint64_t mask = 1ull << (bit & 63);
+            present = present && (doorkeeper_[bit >> 6] & mask);
+            doorkeeper_[bit >> 6] |= mask;
+        }
+        return present;
+    }
+
+    /*!
+     * \brief Age halves every counter and clears the doorkeeper. Halving a
+     * word of sixteen counters is one shift and a mask that drops the bit
+     * each counter got from its neighbour.
+     */
+    void Age()
+    {
+        for (uint64_t& word : counters_)
+        {
+            word = (word >> 1) & 0x7777777777777777ull;
+        }
+        std::fill(doorkeeper_.begin(), doorkeeper_.end(), 0);
+        additions_ /= 2;
+    }
+
+    // Counters in a row minus one
+    uint64_t row_mask_;
+    // Bits in the doorkeeper minus one
+    uint64_t doorkeeper_mask_;
+    // Rows of packed 4-bit counters, one after the other
+    std::vector<uint64_t> counters_;
+    std::vector<uint64_t> doorkeeper_;
+    // Requests recorded since the last aging and the number that triggers it
+    uint64_t additions_;
+    uint64_t sample_size_;
+};
+
+/*!
+ * \brief The WTinyLFUPageCache class is the W-TinyLFU algorithm of Einziger,
+ * Friedman and Manes as an online cache. New pages go into a small LRU
+ * window (1% of the frames). A page pushed out of the window only gets into
+ * the main region if a FrequencySketch says it was requested more often
+ * than the page it would replace, otherwise it is the one evicted. The main
+ * region is a segmented LRU: admitted pages start in the probation segment
+ * and move to the protected segment (80% of the main region) when they are
+ * hit. Frequency is tracked for every requested page, resident or not, in a
+ * few bytes per frame instead of a counter per page.
+ */
+class WTinyLFUPageCache
+{
+public:
+    /*!
+     * \brief WTinyLFUPageCache constructs an empty cache
+     * \param num_frames Number of frames in the system
+     * \param dense_pages Pages below this are looked up in an array, pass 0
+     * when the page ids are not bounded
+     */
+    explicit WTinyLFUPageCache(int num_frames, int dense_pages = 0)
+        : sketch_(num_frames), node_of_(dense_pages)
+    {
+        num_frames_ = num_frames < 0 ? 0 : num_frames;
+        max_window_ = std::min(num_frames_, std::max(1, num_frames_ / 100));
+        max_main_ = num_frames_ - max_window_;
+        max_protected_ = (int) (max_main_ * 8LL / 10);
+
+        // One spare node for the page that is in the window while the
+        // window's oldest page waits for admission
+        node_pages_.assign(num_frames_ + 1, 0);
+        node_of_.Reserve(dense_pages > 0 ? 0 : num_frames_ * 2);
+        Reset();
+    }
+
+    /*!
+     * \brief Access requests a page, swapping it in if it is not in memory
+     * \param page Requested page
+     * \return Whether the request hit and which page was swapped out, if any
+     */
+    PageAccessResult Access(int page)
+    {
+        PageAccessResult result = {true, false, 0};
+        sketch_.Increment(page);
+        int node = node_of_.Find(page);
+
+        if (node >= 0)
+        {
+            int list = lists_.ListOf(node);
+            if (list == kProbation)
+            {
+                // Hit twice, so protect it. The protected segment pushes its
+                // least recently used page back into probation when full.
+                lists_.MoveToBack(kProtected, node);
+                if (lists_.Size(kProtected) > max_protected_)
+                {
+                    lists_.MoveToBack(kProbation, lists_.Front(kProtected));
+                }
+            }
+            else
+            {
+                lists_.MoveToBack(list, node);
+            }
+            return result;
+        }
+
+        result.hit = false;
+        if (num_frames_ == 0)
+        {
+            return result;
+        }
+
+        node = free_nodes_.back();
+        free_nodes_.pop_back();
+        node_pages_[node] = page;
+        node_of_.Set(page, node);
+        lists_.PushBack(kWindow, node);
+
+        if (lists_.Size(kWindow) <= max_window_)
+        {
+            return result;
+        }
+
+        // The window is full, its oldest page is a candidate for the main
+        // region. It gets in for free while the main region has room.
+        int candidate = lists_.Front(kWindow);
+        if (lists_.Size(kProbation) + lists_.Size(kProtected) < max_main_)
+        {
+            lists_.MoveToBack(kProbation, candidate);
+            return result;
+        }
+
+        // Otherwise it has to be more popular than the page the main region
+        // would evict
+        int victim = -1;
+        if (!lists_.Empty(kProbation))
+        {
+            victim = lists_.Front(kProbation);
+        }
+        else if (!lists_.Empty(kProtected))
+        {
+            victim = lists_.Front(kProtected);
+        }
+
+        int evicted = candidate;
+        if (victim >= 0 && sketch_.Estimate(node_pages_[candidate]) > sketch_.Estimate(node_pages_[victim]))
+        {
+            evicted = victim;
+            lists_.MoveToBack(kProbation, candidate);
+        }
+
+        lists_.Remove(evicted);
+        result.evicted = true;
+        result.evicted_page = node_pages_[evicted];
+        node_of_.Erase(result.evicted_page);
+        free_nodes_.push_back(evicted);
+        return result;
+    }
+
+    /*!
+     * \brief AccessMany requests a batch of pages in order
+     * \param pages Requested pages
+     * \return The number of page faults in the batch
+     */
+    int AccessMany(RefStringView pages)
+    {
+        int page_faults = 0;
+        for (auto i = pages.begin(); i != pages.end(); ++i)
+        {
+            page_faults += !Access(*i).hit;
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Reset swaps every page out and forgets every frequency
+     */
+    void Reset()
+    {
+        const int num_nodes = (int) node_pages_.size();
+        lists_.Reset(num_nodes, 3);
+        node_of_.Clear();
+        sketch_.Clear();
+        free_nodes_.clear();
+        for (int node = num_nodes - 1; node >= 0; --node)
+        {
+            free_nodes_.push_back(node);
+        }
+    }
+
+    int NumFrames() const { return num_frames_; }
+    int Size() const { return lists_.Size(kWindow) + lists_.Size(kProbation) + lists_.Size(kProtected); }
+    bool Contains(int page) const { return node_of_.Find(page) >= 0; }
+
+private:
+    // Lists in lists_, least recently used first
+    static const int kWindow = 0;
+    static const int kProbation = 1;
+    static const int kProtected = 2;
+
+    // Number of frames in the system
+    int num_frames_;
+    // Frames of the window, of the main region and of its protected segment
+    int max_window_;
+    int max_main_;
+    int max_protected_;
+    // Recent request frequency of every page
+    FrequencySketch sketch_;
+    // The window, probation and protected lists
+    IndexedList lists_;
+    // Page held by every node
+    std::vector<int> node_pages_;
+    // Nodes that are not in use
+    std::vector<int> free_nodes_;
+    // Page -> node for every resident page
+    PageMap node_of_;
+};
+
+/*!
+ * \brief The WTinyLFUPageReplacement class is used to calculate the number of
+ * page faults in a system using the W-TinyLFU algorithm. See
+ * WTinyLFUPageCache.
+ */
+class WTinyLFUPageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief WTinyLFUPageReplacement constructs a WTinyLFUPageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system
+     */
+    WTinyLFUPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    WTinyLFUPageReplacement(RefStringView ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of page faults using
+     * the W-TinyLFU algorithm
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        WTinyLFUPageCache cache(num_frames_, PageSet::DensePagesFor(ref_string_));
+        return cache.AccessMany(ref_string_);
+    }
+};
+
+/*!
+ * \brief The TwoQPageCache class is the full 2Q algorithm of Johnson and
+ * Shasha as an online cache. A page requested for the first time goes into
+ * A1in, a FIFO of resident pages. When A1in is over its share of the frames
+ * its oldest page is evicted and remembered in A1out, a FIFO of page ids
+ * only. A page that is requested again while it is remembered in A1out has
+ * proven it is not a one-off and goes into Am, an LRU of the pages that
+ * matter. Scans only churn A1in and never reach Am.
+ *
+ * A1in, A1out and Am are IndexedLists over one node pool, so every request
+ * is O(1) and memory only depends on the number of frames.
+ */
+class TwoQPageCache
+{
+public:
+    /*!
+     * \brief TwoQPageCache constructs an empty cache
+     * \param num_frames Number of frames in the system
+     * \param dense_pages Pages below this are looked up in an array, pass 0
+     * when the page ids are not bounded
+     * \param in_ratio Share of the frames A1in may hold before it is evicted
+     * from ahead of Am, 0.25 in the paper
+     * \param out_ratio Number of page ids A1out remembers as a share of the
+     * frames, 0.5 in the paper
+     */
+    explicit TwoQPageCache(int num_frames, int dense_pages = 0,
+                           double in_ratio = 0.25, double out_ratio = 0.5)
+        : node_of_(dense_pages)
+    {
+        num_frames_ = num_frames < 0 ? 0 : num_frames;
+        max_in_ = std::max(1, (int) (num_frames_ * in_ratio));
+        max_out_ = std::max(1, (int) (num_frames_ * out_ratio));
+
+        // One spare node so a page can be evicted into A1out before the
+        // oldest remembered page is dropped
+        node_pages_.assign(num_frames_ + max_out_ + 1, 0);
+        node_of_.Reserve(dense_pages > 0 ? 0 : node_pages_.size() * 2);
+        Reset();
+    }
+
+    /*!
+     * \brief Access requests a page, swapping it in if it is not in memory
+     * \param page Requested page
+     * \return Whether the request hit and which page was swapped out, if any
+     */
+    PageAccessResult Access(int page)
+    {
+        PageAccessResult result = {true, false, 0};
+        int node = node_of_.Find(page);
+        int list = node >= 0 ? lists_.ListOf(node) : -1;
+
+        // Am is an LRU, A1in is a FIFO so a hit there changes nothing
+        if (list == kAm)
+        {
+            lists_.MoveToBack(kAm, node);
+            return result;
+        }
+        if (list == kA1in)
+        {
+            return result;
+        }
+
+        result.hit = false;
+        if (num_frames_ == 0)
+        {
+            return result;
+        }
+
+        // A page remembered in A1out was requested twice in a while, take
+        // it out before A1out makes room for the page that gets evicted
+        if (list == kA1out)
+        {
+            lists_.Remove(node);
+        }
+
+        if (Size() == num_frames_)
+        {
+            result.evicted = true;
+            result.evicted_page = Reclaim();
+        }
+
+        if (list == kA1out)
+        {
+            lists_.PushBack(kAm, node);
+        }
+        else
+        {
+            lists_.PushBack(kA1in, Allocate(page));
+        }
+
+        return result;
+    }
+
+    /*!
+     * \brief AccessMany requests a batch of pages in order
+     * \param pages Requested pages
+     * \return The number of page faults in the batch
+     */
+    int AccessMany(RefStringView pages)
+    {
+        int page_faults = 0;
+        for (auto i = pages.begin(); i != pages.end(); ++i)
+        {
+            page_faults += !Access(*i).hit;
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Reset swaps every page out and forgets A1out
+     */
+    void Reset()
+    {
+        const int num_nodes = (int) node_pages_.size();
+        lists_.Reset(num_nodes, 3);
+        node_of_.Clear();
+        free_nodes_.clear();
+        for (int node = num_nodes - 1; node >= 0; --node)
+        {
+            free_nodes_.push_back(node);
+        }
+    }
+
+    int NumFrames() const { return num_frames_; }
+    int Size() const { return lists_.Size(kA1in) + lists_.Size(kAm); }
+    bool Contains(int page) const
+    {
+        int node = node_of_.Find(page);
+        return node >= 0 && lists_.ListOf(node) != kA1out;
+    }
+
+private:
+    // Lists in lists_, oldest first
+    static const int kA1in = 0;
+    static const int kA1out = 1;
+    static const int kAm = 2;
+
+    /*!
+     * \brief Reclaim frees a frame. A1in gives up its oldest page when it is
+     * over its share (or Am is empty) and that page is remembered in A1out,
+     * otherwise the least recently used page of Am goes.
+     * \return The evicted page
+     */
+    int Reclaim()
+    {
+        int victim;
+        if (lists_.Size(kA1in) > max_in_ || lists_.Empty(kAm))
+        {
+            victim = lists_.Front(kA1in);
+            lists_.MoveToBack(kA1out, victim);
+            if (lists_.Size(kA1out) > max_out_)
+            {
+                Forget(lists_.Front(kA1out));
+            }
+            return node_pages_[victim];
+        }
+
+        victim = lists_.Front(kAm);
+        int page = node_pages_[victim];
+        Forget(victim);
+        return page;
+    }
+
+    int Allocate(int page)
+    {
+        int node = free_nodes_.back();
+        free_nodes_.pop_back();
+        node_pages_[node] = page;
+        node_of_.Set(page, node);
+        return node;
+    }
+
+    void Forget(int node)
+    {
+        lists_.Remove(node);
+        node_of_.Erase(node_pages_[node]);
+        free_nodes_.push_back(node);
+    }
+
+    // Number of frames in the system
+    int num_frames_;
+    // Pages A1in may hold while Am is not empty and page ids A1out holds
+    int max_in_;
+    int max_out_;
+    // The A1in, A1out and Am lists
+    IndexedList lists_;
+    // Page of every node
+    std::vector<int> node_pages_;
+    // Nodes that are not in use
+    std::vector<int> free_nodes_;
+    // Page -> node for every resident or remembered page
+    PageMap node_of_;
+};
+
+/*!
+ * \brief The TwoQPageReplacement class is used to calculate the number of
+ * page faults in a system using the 2Q algorithm. See TwoQPageCache.
+ */
+class TwoQPageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief TwoQPageReplacement constructs a TwoQPageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system
+     * \param in_ratio Share of the frames for A1in
+     * \param out_ratio Page ids remembered in A1out as a share of the frames
+     */
+    TwoQPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames,
+                        double in_ratio = 0.25, double out_ratio = 0.5)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames),
+      in_ratio_(in_ratio), out_ratio_(out_ratio) {}
+
+    TwoQPageReplacement(RefStringView ref_string, int num_pages, int num_frames,
+                        double in_ratio = 0.25, double out_ratio = 0.5)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames),
+      in_ratio_(in_ratio), out_ratio_(out_ratio) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of page faults using
+     * the 2Q algorithm
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        TwoQPageCache cache(num_frames_, PageSet::DensePagesFor(ref_string_), in_ratio_, out_ratio_);
+        return cache.AccessMany(ref_string_);
+    }
+
+private:
+    double in_ratio_;
+    double out_ratio_;
+};
+
+/*!
+ * \brief The SLRUPageCache class is Segmented LRU as an online cache. The
+ * frames are split into a probation and a protected segment, both LRU. A
+ * missed page enters probation and pages are only ever evicted from there.
+ * A hit in probation promotes the page to protected, and when protected is
+ * over its share it pushes its least recently used page back into
+ * probation. Pages requested only once never displace pages requested
+ * twice. Both segments are IndexedLists over the frames.
+ */
+class SLRUPageCache
+{
+public:
+    /*!
+     * \brief SLRUPageCache constructs an empty cache
+     * \param num_frames Number of frames in the system
+     * \param dense_pages Pages below this are looked up in an array, pass 0
+     * when the page ids are not bounded
+     * \param protected_ratio Share of the frames of the protected segment
+     */
+    explicit SLRUPageCache(int num_frames, int dense_pages = 0, double protected_ratio = 0.8)
+        : frame_of_(dense_pages)
+    {
+        num_frames_ = num_frames < 0 ? 0 : num_frames;
+        max_protected_ = std::min(num_frames_, std::max(0, (int) (num_frames_ * protected_ratio)));
+        frame_pages_.assign(num_frames_, 0);
+        frame_of_.Reserve(dense_pages > 0 ? 0 : num_frames_ * 2);
+        Reset();
+    }
+
+    /*!
+     * \brief Access requests a page, swapping it in if it is not in memory
+     * \param page Requested page
+     * \return Whether the request hit and which page was swapped out, if any
+     */
+    PageAccessResult Access(int page)
+    {
+        PageAccessResult result = {true, false, 0};
+        int frame = frame_of_.Find(page);
+
+        if (frame >= 0)
+        {
+            if (lists_.ListOf(frame) == kProbation)
+            {
+                lists_.MoveToBack(kProtected, frame);
+                if (lists_.Size(kProtected) > max_protected_)
+                {
+                    lists_.MoveToBack(kProbation, lists_.Front(kProtected));
+                }
+            }
+            else
+            {
+                lists_.MoveToBack(kProtected, frame);
+            }
+            return result;
+        }
+
+        result.hit = false;
+        if (num_frames_ == 0)
+        {
+            return result;
+        }
+
+        // Take a free frame if there is one, otherwise evict the least
+        // recently used page of probation. Probation is only empty when
+        // every frame is protected.
+        if (used_frames_ < num_frames_)
+        {
+            frame = used_frames_++;
+        }
+        else
+        {
+            frame = lists_.Empty(kProbation) ? lists_.Front(kProtected) : lists_.Front(kProbation);
+            lists_.Remove(frame);
+            result.evicted = true;
+            result.evicted_page = frame_pages_[frame];
+            frame_of_.Erase(result.evicted_page);
+        }
+
+        frame_pages_[frame] = page;
+        frame_of_.Set(page, frame);
+        lists_.PushBack(kProbation, frame);
+        return result;
+    }
+
+    /*!
+     * \brief AccessMany requests a batch of pages in order
+     * \param pages Requested pages
+     * \return The number of page faults in the batch
+     */
+    int AccessMany(RefStringView pages)
+    {
+        int page_faults = 0;
+        for (auto i = pages.begin(); i != pages.end(); ++i)
+        {
+            page_faults += !Access(*i).hit;
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Reset swaps every page out
+     */
+    void Reset()
+    {
+        lists_.Reset(num_frames_, 2);
+        frame_of_.Clear();
+        used_frames_ = 0;
+    }
+
+    int NumFrames() const { return num_frames_; }
+    int Size() const { return used_frames_; }
+    bool Contains(int page) const { return frame_of_.Find(page) >= 0; }
+
+private:
+    // Lists in lists_, least recently used first
+    static const int kProbation = 0;
+    static const int kProtected = 1;
+
+    // Number of frames in the system
+    int num_frames_;
+    // Frames the protected segment may hold
+    int max_protected_;
+    // The probation and protected segments
+    IndexedList lists_;
+    // Page held in every frame
+    std::vector<int> frame_pages_;
+    // Resident page -> frame it is held in
+    PageMap frame_of_;
+    // Number of frames handed out so far
+    int used_frames_;
+};
+
+/*!
+ * \brief The SLRUPageReplacement class is used to calculate the number of
+ * page faults in a system using the Segmented LRU algorithm. See
+ * SLRUPageCache.
+ */
+class SLRUPageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief SLRUPageReplacement constructs a SLRUPageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system
+     * \param protected_ratio Share of the frames of the protected segment
+     */
+    SLRUPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames,
+                        double protected_ratio = 0.8)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames),
+      protected_ratio_(protected_ratio) {}
+
+    SLRUPageReplacement(RefStringView ref_string, int num_pages, int num_frames,
+                        double protected_ratio = 0.8)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames),
+      protected_ratio_(protected_ratio) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of page faults using
+     * the Segmented LRU algorithm
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        SLRUPageCache cache(num_frames_, PageSet::DensePagesFor(ref_string_), protected_ratio_);
+        return cache.AccessMany(ref_string_);
+    }
+
+private:
+    double protected_ratio_;
+};
+
+/*!
+ * \brief The LFUPageCache class is the LFU algorithm as an online cache with
+ * O(1) hits and misses, using the frequency bucket structure of Shah, Mitra
+ * and Matani. Resident pages with the same request count share a bucket and
+ * the buckets are linked in increasing count order, so the least frequently
+ * used page is always at the front of the first bucket and a hit only moves
+ * a page into the neighbouring bucket. Pages with the same count are evicted
+ * least recently used first.
+ *
+ * Counts can optionally be halved every so many requests so that pages
+ * which were hot long ago do not stay resident forever.
+ */
+class LFUPageCache
+{
+public:
+    /*!
+     * \brief LFUPageCache constructs an empty cache
+     * \param num_frames Number of frames in the system
+     * \param dense_pages Pages below this are looked up in an array, pass 0
+     * when the page ids are not bounded
+     * \param aging_period Number of requests between two halvings of every
+     * count, 0 never ages
+     */
+    explicit LFUPageCache(int num_frames, int dense_pages = 0, int aging_period = 0)
+        : frame_of_(dense_pages)
+    {
+        num_frames_ = num_frames < 0 ? 0 : num_frames;
+        aging_period_ = aging_period < 0 ? 0 : aging_period;
+        frame_pages_.assign(num_frames_, 0);
+        frame_bucket_.assign(num_frames_, -1);
+        bucket_counts_.assign(num_frames_, 0);
+        frame_of_.Reserve(dense_pages > 0 ? 0 : num_frames_ * 2);
+        Reset();
+    }
+
+    /*!
+     * \brief Access requests a page, swapping it in if it is not in memory
+     * \param page Requested page
+     * \return Whether the request hit and which page was swapped out, if any
+     */
+    PageAccessResult Access(int page)
+    {
+        PageAccessResult result = {true, false, 0};
+
+        if (aging_period_ > 0 && ++requests_since_aging_ >= aging_period_)
+        {
+            Age();
+        }
+
+        int frame = frame_of_.Find(page);
+        if (frame >= 0)
+        {
+            Increment(frame);
+            return result;
+        }
+
+        result.hit = false;
+        if (num_frames_ == 0)
+        {
+            return result;
+        }
+
+        // Take a free frame if there is one, otherwise evict the least
+        // recently used of the least frequently used pages
+        if (used_frames_ < num_frames_)
+        {
+            frame = used_frames_++;
+        }
+        else
+        {
+            frame = frames_.Front(buckets_.Front(0));
+            Unlink(frame);
+            result.evicted = true;
+            result.evicted_page = frame_pages_[frame];
+            frame_of_.Erase(result.evicted_page);
+        }
+
+        frame_pages_[frame] = page;
+        frame_of_.Set(page, frame);
+
+        // A new page has been requested once
+        int first = buckets_.Front(0);
+        if (first == buckets_.End(0) || bucket_counts_[first] != 1)
+        {
+            first = NewBucket(first, 1);
+        }
+        Link(frame, first);
+        return result;
+    }
+
+    /*!
+     * \brief AccessMany requests a batch of pages in order
+     * \param pages Requested pages
+     * \return The number of page faults in the batch
+     */
+    int AccessMany(RefStringView pages)
+    {
+        int page_faults = 0;
+        for (auto i = pages.begin(); i != pages.end(); ++i)
+        {
+            page_faults += !Access(*i).hit;
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Reset swaps every page out
+     */
+    void Reset()
+    {
+        // A bucket always holds at least one page so there are never more
+        // buckets than frames
+        frames_.Reset(num_frames_, num_frames_);
+        buckets_.Reset(num_frames_, 1);
+        frame_of_.Clear();
+        free_buckets_.clear();
+        for (int bucket = num_frames_ - 1; bucket >= 0; --bucket)
+        {
+            free_buckets_.push_back(bucket);
+        }
+        used_frames_ = 0;
+        requests_since_aging_ = 0;
+    }
+
+    int NumFrames() const { return num_frames_; }
+    int Size() const { return used_frames_; }
+    bool Contains(int page) const { return frame_of_.Find(page) >= 0; }
+
+    /*!
+     * \brief Count returns the request count of a resident page
+     * \return The count or 0 if the page is not resident
+     */
+    int Count(int page) const
+    {
+        int frame = frame_of_.Find(page);
+        return frame >= 0 ? bucket_counts_[frame_bucket_[frame]] : 0;
+    }
+
+private:
+    /*!
+     * \brief NewBucket takes a free bucket and links it in front of another
+     * bucket, which may be the end of the bucket list
+     */
+    int NewBucket(int before, int count)
+    {
+        int bucket = free_buckets_.back();
+        free_buckets_.pop_back();
+        bucket_counts_[bucket] = count;
+        buckets_.InsertBefore(before, bucket, 0);
+        return bucket;
+    }
+
+    void Link(int frame, int bucket)
+    {
+        frames_.PushBack(bucket, frame);
+        frame_bucket_[frame] = bucket;
+    }
+
+    /*!
+     * \brief Unlink takes a frame out of its bucket and frees the bucket if
+     * that left it empty
+     */
+    void Unlink(int frame)
+    {
+        int bucket = frame_bucket_[frame];
+        frames_.Remove(frame);
+        if (frames_.Empty(bucket))
+        {
+            buckets_.Remove(bucket);
+            free_buckets_.push_back(bucket);
+        }
+    }
+
+    /*!
+     * \brief Increment moves a frame into the bucket of the next count
+     */
+    void Increment(int frame)
+    {
+        int bucket = frame_bucket_[frame];
+        int count = bucket_counts_[bucket];
+
+        // Alone in its bucket with no bucket for the next count, the
+        // bucket itself can just count up
+        int next = buckets_.Next(bucket);
+        bool next_fits = next != buckets_.End(0) && bucket_counts_[next] == count + 1;
+        if (!next_fits && frames_.Size(bucket) == 1)
+        {
+            bucket_counts_[bucket] = count + 1;
+            frames_.MoveToBack(bucket, frame);
+            return;
+        }
+
+        if (!next_fits)
+        {
+            next = NewBucket(next, count + 1);
+        }
+        Unlink(frame);
+        Link(frame, next);
+    }
+
+    /*!
+     * \brief Age halves every count, keeping it at least 1. The order of
+     * the buckets is kept, buckets that end up with the same count are
+     * merged with the pages of the lower old count in front.
+     */
+    void Age()
+    {
+        requests_since_aging_ = 0;
+
+        int previous = -1;
+        int bucket = buckets_.Front(0);
+        while (bucket != buckets_.End(0))
+        {
+            int next = buckets_.Next(bucket);
+            int count = std::max(1, bucket_counts_[bucket] / 2);
+
+            if (previous >= 0 && bucket_counts_[previous] == count)
+            {
+                while (!frames_.Empty(bucket))
+                {
+                    int frame = frames_.Front(bucket);
+                    frames_.Remove(frame);
+                    Link(frame, previous);
+                }
+                buckets_.Remove(bucket);
+                free_buckets_.push_back(bucket);
+            }
+            else
+            {
+                bucket_counts_[bucket] = count;
+                previous = bucket;
+            }
+            bucket = next;
+        }
+    }
+
+    // Number of frames in the system
+    int num_frames_;
+    // Requests between two agings, 0 for none, and requests since the last
+    int aging_period_;
+    int requests_since_aging_;
+    // One list of frames per bucket, least recently used first
+    IndexedList frames_;
+    // The buckets in increasing count order
+    IndexedList buckets_;
+    // Count of every bucket
+    std::vector<int> bucket_counts_;
+    // Buckets that are not in use
+    std::vector<int> free_buckets_;
+    // Page held in every frame and the bucket the frame is in
+    std::vector<int> frame_pages_;
+    std::vector<int> frame_bucket_;
+    // Resident page -> frame it is held in
+    PageMap frame_of_;
+    // Number of frames handed out so far
+    int used_frames_;
+};
+
+/*!
+ * \brief The LFUPageReplacement class is used to calculate the number of page
+ * faults in a system using the LFU algorithm. See LFUPageCache.
+ */
+class LFUPageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief LFUPageReplacement constructs a LFUPageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system
+     * \param aging_period Requests between two halvings of every count, 0
+     * never ages
+     */
+    LFUPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames,
+                       int aging_period = 0)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames),
+      aging_period_(aging_period) {}
+
+    LFUPageReplacement(RefStringView ref_string, int num_pages, int num_frames,
+                       int aging_period = 0)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames),
+      aging_period_(aging_period) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of page faults using
+     * the LFU algorithm
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        LFUPageCache cache(num_frames_, PageSet::DensePagesFor(ref_string_), aging_period_);
+        return cache.AccessMany(ref_string_);
+    }
+
+private:
+    int aging_period_;
+};
+
+/*!
+ * \brief The S3FIFOPageCache class is the S3-FIFO algorithm of Yang et al.
+ * as an online cache. It only ever uses FIFO queues. New pages go into a
+ * small queue (10% of the frames). A page that reaches the end of the small
+ * queue without being hit is evicted and its id is remembered in a ghost
+ * queue, and a page that was hit moves on to the main queue. Pages in the
+ * ghost queue go straight into the main queue when they are requested again.
+ * The main queue evicts like CLOCK with a 2-bit counter: a page that was hit
+ * is put back at the front with its counter decremented.
+ *
+ * Every queue is a ring buffer of frames (or page ids for the ghosts) and the
+ * counters are packed 32 to a word, so a hit is one PageMap lookup and a
+ * counter bump.
+ */
+class S3FIFOPageCache
+{
+public:
+    /*!
+     * \brief S3FIFOPageCache constructs an empty cache
+     * \param num_frames Number of frames in the system
+     * \param dense_pages Pages below this are looked up in an array, pass 0
+     * when the page ids are not bounded
+     * \param small_ratio Share of the frames of the small queue
+     */
+    explicit S3FIFOPageCache(int num_frames, int dense_pages = 0, double small_ratio = 0.1)
+        : frame_of_(dense_pages), ghost_of_(dense_pages)
+    {
+        num_frames_ = num_frames < 0 ? 0 : num_frames;
+        max_small_ = std::min(num_frames_, std::max(1, (int) (num_frames_ * small_ratio)));
+
+        // The ghost queue remembers as many pages as the main queue holds
+        int num_ghosts = std::max(1, num_frames_ - max_small_);
+
+        frame_pages_.assign(num_frames_, 0);
+        frequency_.assign((num_frames_ + 31) / 32, 0);
+        small_.assign(num_frames_, 0);
+        main_.assign(num_frames_, 0);
+        ghosts_.assign(num_ghosts, 0);
+        frame_of_.Reserve(dense_pages > 0 ? 0 : num_frames_ * 2);
+        ghost_of_.Reserve(dense_pages > 0 ? 0 : num_ghosts * 2);
+        Reset();
+    }
+
+    /*!
+     * \brief Access requests a page, swapping it in if it is not in memory
+     * \param page Requested page
+     * \return Whether the request hit and which page was swapped out, if any
+     */
+    PageAccessResult Access(int page)
+    {
+        PageAccessResult result = {true, false, 0};
+        int frame = frame_of_.Find(page);
+
+        // A hit only bumps the counter, saturating at 3
+        if (frame >= 0)
+        {
+            int count = Frequency(frame);
+            if (count < 3)
+            {
+                SetFrequency(frame, count + 1);
+            }
+            return result;
+        }
+
+        result.hit = false;
+        if (num_frames_ == 0)
+        {
+            return result;
+        }
+
+        // A page that was evicted from the small queue not long ago has been
+        // requested twice, so it skips the small queue. The ghost is looked
+        // up before evicting, which may push it out of the ghost queue.
+        bool ghost = ghost_of_.Find(page) >= 0;
+        if (ghost)
+        {
+            ghost_of_.Erase(page);
+        }
+
+        if (used_frames_ < num_frames_)
+        {
+            frame = used_frames_++;
+        }
+        else
+        {
+            frame = Evict();
+            result.evicted = true;
+            result.evicted_page = frame_pages_[frame];
+            frame_of_.Erase(result.evicted_page);
+        }
+
+        frame_pages_[frame] = page;
+        frame_of_.Set(page, frame);
+        SetFrequency(frame, 0);
+
+        if (ghost)
+        {
+            Push(main_, main_head_, main_size_, frame);
+        }
+        else
+        {
+            Push(small_, small_head_, small_size_, frame);
+        }
+        return result;
+    }
+
+    /*!
+     * \brief AccessMany requests a batch of pages in order
+     * \param pages Requested pages
+     * \return The number of page faults in the batch
+     */
+    int AccessMany(RefStringView pages)
+    {
+        int page_faults = 0;
+        for (auto i = pages.begin(); i != pages.end(); ++i)
+        {
+            page_faults += !Access(*i).hit;
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Reset swaps every page out and forgets the ghosts
+     */
+    void Reset()
+    {
+        frame_of_.Clear();
+        ghost_of_.Clear();
+        std::fill(frequency_.begin(), frequency_.end(), 0);
+        small_head_ = small_size_ = 0;
+        main_head_ = main_size_ = 0;
+        ghost_head_ = 0;
+        used_frames_ = 0;
+    }
+
+    int NumFrames() const { return num_frames_; }
+    int Size() const { return used_frames_; }
+    bool Contains(int page) const { return frame_of_.Find(page) >= 0; }
+
+private:
+    int Frequency(int frame) const
+    {
+        return (int) ((frequency_[frame >> 5] >> ((frame & 31) * 2)) & 3);
+    }
+
+    void SetFrequency(int frame, int count)
+    {
+        uint64_t& word = frequency_[frame >> 5];
+        int shift = (frame & 31) * 2;
+        word = (word & ~(3ull << shift)) | ((uint64_t) count << shift);
+    }
+
+    /*!
+     * \brief Push appends to the back of a ring buffer of frames
+     */
+    static void Push(std::vector<int>& ring, int head, int& size, int frame)
+    {
+        int slot = head + size;
+        ring[slot >= (int) ring.size() ? slot - (int) ring.size() : slot] = frame;
+        size += 1;
+    }
+
+    /*!
+     * \brief Pop takes the front of a ring buffer of frames
+     */
+    static int Pop(const std::vector<int>& ring, int& head, int& size)
+    {
+        int frame = ring[head];
+        head = head + 1 == (int) ring.size() ? 0 : head + 1;
+        size -= 1;
+        return frame;
+    }
+
+    /*!
+     * \brief Evict frees a frame. The small queue gives up a page while it
+     * is over its share, otherwise the main queue does.
+     * \return The frame whose page was evicted
+     */
+    int Evict()
+    {
+        // Pages that were hit in the small queue move on to the main queue
+        // until one that was not hit comes up
+        while (small_size_ >= max_small_ && small_size_ > 0)
+        {
+            int frame = Pop(small_, small_head_, small_size_);
+            if (Frequency(frame) > 0)
+            {
+                SetFrequency(frame, 0);
+                Push(main_, main_head_, main_size_, frame);
+            }
+            else
+            {
+                RememberGhost(frame_pages_[frame]);
+                return frame;
+            }
+        }
+
+        // The main queue gives every hit page another round, which ends
+        // because every round lowers a counter
+        for (;;)
+        {
+            int frame = Pop(main_, main_head_, main_size_);
+            int count = Frequency(frame);
+            if (count == 0)
+            {
+                return frame;
+            }
+            SetFrequency(frame, count - 1);
+            Push(main_, main_head_, main_size_, frame);
+        }
+    }
+
+    /*!
+     * \brief RememberGhost adds a page to the ghost queue, overwriting the
+     * oldest ghost. A ghost that was requested in the meantime has already
+     * left ghost_of_, so its stale slot is just overwritten.
+     */
+    void RememberGhost(int page)
+    {
+        int forgotten = ghosts_[ghost_head_];
+        if (ghost_of_.Find(forgotten) == ghost_head_)
+        {
+            ghost_of_.Erase(forgotten);
+        }
+
+        ghosts_[ghost_head_] = page;
+        ghost_of_.Set(page, ghost_head_);
+        ghost_head_ = ghost_head_ + 1 == (int) ghosts_.size() ? 0 : ghost_head_ + 1;
+    }
+
+    // Number of frames in the system
+    int num_frames_;
+    // Frames the small queue holds before it starts evicting
+    int max_small_;
+    // Page held in every frame
+    std::vector<int> frame_pages_;
+    // 2-bit hit counter of every frame, 32 to a word
+    std::vector<uint64_t> frequency_;
+    // The small and main queues, ring buffers of frames
+    std::vector<int> small_;
+    int small_head_;
+    int small_size_;
+    std::vector<int> main_;
+    int main_head_;
+    int main_size_;
+    // The ghost queue, a ring buffer of page ids that is always full
+    std::vector<int> ghosts_;
+    int ghost_head_;
+    // Resident page -> frame it is held in
+    PageMap frame_of_;
+    // Ghost page -> slot in ghosts_
+    PageMap ghost_of_;
+    // Number of frames handed out so far
+    int used_frames_;
+};
+
+/*!
+ * \brief The S3FIFOPageReplacement class is used to calculate the number of
+ * page faults in a system using the S3-FIFO algorithm. See S3FIFOPageCache.
+ */
+class S3FIFOPageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief S3FIFOPageReplacement constructs a S3FIFOPageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system
+     */
+    S3FIFOPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    S3FIFOPageReplacement(RefStringView ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of page faults using
+     * the S3-FIFO algorithm
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        S3FIFOPageCache cache(num_frames_, PageSet::DensePagesFor(ref_string_));
+        return cache.AccessMany(ref_string_);
+    }
+};
+
+/*!
+ * \brief The SievePageCache class is the SIEVE algorithm of Zhang et al. as an
+ * online cache. Pages are kept in arrival order with a visited bit each. A
+ * hand walks from the oldest page towards the newest, clearing visited bits,
+ * and evicts the first page whose bit was already clear. Unlike CLOCK the new
+ * page does not take the victim's place but goes to the newest end, so
+ * pages that survive a pass of the hand stay behind it and new pages have to
+ * prove themselves before the hand comes back.
+ *
+ * Because victims are taken from the middle of the queue it is an
+ * IndexedList over the frames rather than a ring, and the visited bits are
+ * packed 64 to a word as in ClockPageCache.
+ */
+class SievePageCache
+{
+public:
+    /*!
+     * \brief SievePageCache constructs an empty cache
+     * \param num_frames Number of frames in the system
+     * \param dense_pages Pages below this are looked up in an array, pass 0
+     * when the page ids are not bounded
+     */
+    explicit SievePageCache(int num_frames, int dense_pages = 0)
+        : frame_of_(dense_pages)
+    {
+        num_frames_ = num_frames < 0 ? 0 : num_frames;
+        frame_pages_.assign(num_frames_, 0);
+        visited_.assign((num_frames_ + 63) / 64, 0);
+        frame_of_.Reserve(dense_pages > 0 ? 0 : num_frames_ * 2);
+        Reset();
+    }
+
+    /*!
+     * \brief Access requests a page, swapping it in if it is not in memory
+     * \param page Requested page
+     * \return Whether the request hit and which page was swapped out, if any
+     */
+    PageAccessResult Access(int page)
+    {
+        PageAccessResult result = {true, false, 0};
+        int frame = frame_of_.Find(page);
+
+        // A hit only marks the frame as visited
+        if (frame >= 0)
+        {
+            visited_[frame >> 6] |= 1ull << (frame & 63);
+            return result;
+        }
+
+        result.hit = false;
+        if (num_frames_ == 0)
+        {
+            return result;
+        }
+
+        if (used_frames_ < num_frames_)
+        {
+            frame = used_frames_++;
+        }
+        else
+        {
+            frame = SweepHand();
+            result.evicted = true;
+            result.evicted_page = frame_pages_[frame];
+            frame_of_.Erase(result.evicted_page);
+        }
+
+        frame_pages_[frame] = page;
+        frame_of_.Set(page, frame);
+        visited_[frame >> 6] &= ~(1ull << (frame & 63));
+        queue_.PushBack(0, frame);
+        return result;
+    }
+
+    /*!
+     * \brief AccessMany requests a batch of pages in order
+     * \param pages Requested pages
+     * \return The number of page faults in the batch
+     */
+    int AccessMany(RefStringView pages)
+    {
+        int page_faults = 0;
+        for (auto i = pages.begin(); i != pages.end(); ++i)
+        {
+            page_faults += !Access(*i).hit;
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Reset swaps every page out
+     */
+    void Reset()
+    {
+        queue_.Reset(num_frames_);
+        frame_of_.Clear();
+        std::fill(visited_.begin(), visited_.end(), 0);
+        hand_ = queue_.End(0);
+        used_frames_ = 0;
+    }
+
+    int NumFrames() const { return num_frames_; }
+    int Size() const { return used_frames_; }
+    bool Contains(int page) const { return frame_of_.Find(page) >= 0; }
+
+private:
+    /*!
+     * \brief SweepHand moves the hand to the first frame that was not
+     * visited, clearing the visited bits it passes, and unlinks that frame.
+     * The hand is left on the next newer frame.
+     * \return The frame to evict
+     */
+    int SweepHand()
+    {
+        for (;;)
+        {
+            // Past the newest page the hand starts over at the oldest
+            if (hand_ == queue_.End(0))
+            {
+                hand_ = queue_.Front(0);
+            }
+
+            uint64_t& word = visited_[hand_ >> 6];
+            uint64_t bit = 1ull << (hand_ & 63);
+            if (!(word & bit))
+            {
+                int victim = hand_;
+                hand_ = queue_.Next(victim);
+                queue_.Remove(victim);
+                return victim;
+            }
+
+            word &= ~bit;
+            hand_ = queue_.Next(hand_);
+        }
+    }
+
+    // Number of frames in the system
+    int num_frames_;
+    // Frames from the oldest to the newest page
+    IndexedList queue_;
+    // Page held in every frame
+    std::vector<int> frame_pages_;
+    // Visited bit of every frame, 64 to a word
+    std::vector<uint64_t> visited_;
+    // Frame the hand points at, the end of queue_ when it has to start over
+    int hand_;
+    // Resident page -> frame it is held in
+    PageMap frame_of_;
+    // Number of frames handed out so far
+    int used_frames_;
+};
+
+/*!
+ * \brief The SievePageReplacement class is used to calculate the number of
+ * page faults in a system using the SIEVE algorithm. See SievePageCache.
+ */
+class SievePageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief SievePageReplacement constructs a SievePageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system
+     */
+    SievePageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    SievePageReplacement(RefStringView ref_string, int num_pages, int num_frames)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of page faults using
+     * the SIEVE algorithm
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        SievePageCache cache(num_frames_, PageSet::DensePagesFor(ref_string_));
+        return cache.AccessMany(ref_string_);
+    }
+};
+
+/*!
+ * \brief The ResidentSetTimeline class records how many frames a variable
+ * space algorithm holds after every request. The average and the peak are
+ * kept as it goes, the per request sizes only when they were asked for, so
+ * the timeline can be left out on traces too long to keep it.
+ */
+class ResidentSetTimeline
+{
+public:
+    /*!
+     * \brief ResidentSetTimeline constructs an empty timeline
+     * \param keep_sizes Whether to keep the size after every request
+     */
+    explicit ResidentSetTimeline(bool keep_sizes = true)
+        : keep_sizes_(keep_sizes)
+    {
+        Clear();
+    }
+
+    /*!
+     * \brief Record adds the resident set size after a request
+     */
+    void Record(int size)
+    {
+        if (keep_sizes_)
+        {
+            sizes_.push_back(size);
+        }
+        total_ += (uint64_t) size;
+        peak_ = size > peak_ ? size : peak_;
+        num_requests_ += 1;
+    }
+
+    void Reserve(size_t num_requests)
+    {
+        if (keep_sizes_)
+        {
+            sizes_.reserve(num_requests);
+        }
+    }
+
+    void Clear()
+    {
+        sizes_.clear();
+        total_ = 0;
+        peak_ = 0;
+        num_requests_ = 0;
+    }
+
+    /*!
+     * \brief Sizes returns the size after every request, empty unless the
+     * timeline keeps them
+     */
+    const std::vector<int>& Sizes() const { return sizes_; }
+    double Average() const { return num_requests_ == 0 ? 0.0 : (double) total_ / (double) num_requests_; }
+    int Peak() const { return peak_; }
+    uint64_t NumRequests() const { return num_requests_; }
+
+private:
+    bool keep_sizes_;
+    std::vector<int> sizes_;
+    // Sum of every recorded size, for the average
+    uint64_t total_;
+    int peak_;
+    uint64_t num_requests_;
+};
+
+/*!
+ * \brief The WorkingSetPageCache class is Denning's working set model as an
+ * online cache. There is no fixed number of frames: the resident set after a
+ * request is exactly the pages requested in the last window requests, so it
+ * grows and shrinks with the locality of the program. A request faults when
+ * its page was not requested in the window before it.
+ *
+ * The last window requests are kept in a ring buffer together with, for
+ * every page in the working set, the slot of its latest request. The request
+ * that slides out of the window is the one whose slot is about to be
+ * overwritten, and its page leaves the working set only if that slot was its
+ * latest request, so every request is O(1) and memory is O(window).
+ */
+class WorkingSetPageCache
+{
+public:
+    /*!
+     * \brief WorkingSetPageCache constructs an empty cache
+     * \param window The working set window tau, in requests
+     * \param dense_pages Pages below this are looked up in an array, pass 0
+     * when the page ids are not bounded
+     */
+    explicit WorkingSetPageCache(int window, int dense_pages = 0)
+        : latest_slot_(dense_pages)
+    {
+        window_ = window < 0 ? 0 : window;
+        history_.assign(window_, 0);
+        latest_slot_.Reserve(dense_pages > 0 ? 0 : window_ * 2);
+        Reset();
+    }
+
+    /*!
+     * \brief Access requests a page. Besides the page itself at most one
+     * page leaves the working set, the one requested a window ago.
+     * \param page Requested page
+     * \return Whether the request hit and which page was swapped out, if any
+     */
+    PageAccessResult Access(int page)
+    {
+        PageAccessResult result = {true, false, 0};
+        if (window_ == 0)
+        {
+            result.hit = false;
+            return result;
+        }
+
+        // Hits are decided against the window before this request
+        int slot = latest_slot_.Find(page);
+        if (slot < 0)
+        {
+            result.hit = false;
+            size_ += 1;
+        }
+
+        // The request a window ago slides out. Its page leaves unless it was
+        // requested again since, which includes this request.
+        if (filled_ == window_)
+        {
+            int leaving = history_[next_slot_];
+            if (leaving != page && latest_slot_.Find(leaving) == next_slot_)
+            {
+                latest_slot_.Erase(leaving);
+                size_ -= 1;
+                result.evicted = true;
+                result.evicted_page = leaving;
+            }
+        }
+        else
+        {
+            filled_ += 1;
+        }
+
+        history_[next_slot_] = page;
+        latest_slot_.Set(page, next_slot_);
+        next_slot_ = next_slot_ + 1 == window_ ? 0 : next_slot_ + 1;
+        return result;
+    }
+
+    /*!
+     * \brief AccessMany requests a batch of pages in order
+     * \param pages Requested pages
+     * \return The number of page faults in the batch
+     */
+    int AccessMany(RefStringView pages)
+    {
+        int page_faults = 0;
+        for (auto i = pages.begin(); i != pages.end(); ++i)
+        {
+            page_faults += !Access(*i).hit;
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Reset empties the working set and the window
+     */
+    void Reset()
+    {
+        latest_slot_.Clear();
+        next_slot_ = 0;
+        filled_ = 0;
+        size_ = 0;
+    }
+
+    int Window() const { return window_; }
+    int Size() const { return size_; }
+    bool Contains(int page) const { return latest_slot_.Find(page) >= 0; }
+
+private:
+    // The window tau
+    int window_;
+    // The last window requests, oldest at next_slot_ once it is full
+    std::vector<int> history_;
+    int next_slot_;
+    int filled_;
+    // Page in the working set -> slot of its latest request
+    PageMap latest_slot_;
+    // Number of pages in the working set
+    int size_;
+};
+
+/*!
+ * \brief The WorkingSetPageReplacement class is used to calculate the number
+ * of page faults in a system using the working set model. See
+ * WorkingSetPageCache. The working set never holds more pages than the
+ * window, so num_frames_ is the window. Besides the faults it records the
+ * resident set size after every request.
+ */
+class WorkingSetPageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief WorkingSetPageReplacement constructs a WorkingSetPageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param window The working set window tau, in requests
+     */
+    WorkingSetPageReplacement(std::vector<int>& ref_string, int num_pages, int window)
+    :AbstractPageReplacement(ref_string, num_pages, window) {}
+
+    WorkingSetPageReplacement(RefStringView ref_string, int num_pages, int window)
+    :AbstractPageReplacement(ref_string, num_pages, window) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of page faults using
+     * the working set model and records the resident set sizes
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        WorkingSetPageCache cache(num_frames_, PageSet::DensePagesFor(ref_string_));
+        timeline_.Clear();
+        timeline_.Reserve(ref_string_.size());
+
+        int page_faults = 0;
+        for (auto i = ref_string_.begin(); i != ref_string_.end(); ++i)
+        {
+            page_faults += !cache.Access(*i).hit;
+            timeline_.Record(cache.Size());
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Timeline returns the resident set sizes of the last
+     * CalculatePageFaults
+     */
+    const ResidentSetTimeline& Timeline() const { return timeline_; }
+
+private:
+    ResidentSetTimeline timeline_;
+};
+
+/*!
+ * \brief The WSClockPageCache class is the WSClock algorithm of Carr and
+ * Hennessy as an online cache. The resident pages form a circle with a
+ * reference bit and a virtual time of last use each, like CLOCK. On a fault
+ * the hand moves on: a referenced page gets its bit cleared and its time of
+ * last use set to now, and the first page that is not referenced and was
+ * last used more than a window ago is outside the working set and gets
+ * replaced. While there are free frames the hand only looks a few pages
+ * ahead before the resident set grows by a frame instead. Once it holds
+ * every frame of the system the hand goes around once, and if every page is
+ * in the working set the page that was used longest ago is replaced anyway.
+ *
+ * Hits are O(1), and so are faults while the resident set is growing. With
+ * every frame in use a fault is O(1) amortised while the hand keeps finding
+ * old pages quickly and O(resident pages) when it has to go all the way
+ * around.
+ */
+class WSClockPageCache
+{
+public:
+    /*!
+     * \brief WSClockPageCache constructs an empty cache
+     * \param window The working set window tau, in requests
+     * \param num_frames Number of frames in the system, the most the
+     * resident set can grow to
+     * \param dense_pages Pages below this are looked up in an array, pass 0
+     * when the page ids are not bounded
+     */
+    WSClockPageCache(int window, int num_frames, int dense_pages = 0)
+        : frame_of_(dense_pages)
+    {
+        window_ = window < 0 ? 0 : window;
+        num_frames_ = num_frames < 0 ? 0 : num_frames;
+        frame_pages_.assign(num_frames_, 0);
+        last_use_.assign(num_frames_, 0);
+        referenced_.assign((num_frames_ + 63) / 64, 0);
+        frame_of_.Reserve(dense_pages > 0 ? 0 : num_frames_ * 2);
+        Reset();
+    }
+
+    /*!
+     * \brief Access requests a page, swapping it in if it is not in memory
+     * \param page Requested page
+     * \return Whether the request hit and which page was swapped out, if any
+     */
+    PageAccessResult Access(int page)
+    {
+        PageAccessResult result = {true, false, 0};
+        now_ += 1;
+        int frame = frame_of_.Find(page);
+
+        if (frame >= 0)
+        {
+            referenced_[frame >> 6] |= 1ull << (frame & 63);
+            return result;
+        }
+
+        result.hit = false;
+        if (num_frames_ == 0)
+        {
+            return result;
+        }
+
+        frame = SweepHand();
+        if (frame >= 0)
+        {
+            // Replaced in place, the hand moves on past the new page
+            result.evicted = true;
+            result.evicted_page = frame_pages_[frame];
+            frame_of_.Erase(result.evicted_page);
+            hand_ = circle_.Next(frame);
+        }
+        else
+        {
+            // A new frame goes just behind the hand, so it is the last one
+            // the hand reaches
+            frame = used_frames_++;
+            circle_.InsertBefore(hand_, frame, 0);
+        }
+
+        frame_pages_[frame] = page;
+        frame_of_.Set(page, frame);
+        last_use_[frame] = now_;
+        referenced_[frame >> 6] &= ~(1ull << (frame & 63));
+        return result;
+    }
+
+    /*!
+     * \brief AccessMany requests a batch of pages in order
+     * \param pages Requested pages
+     * \return The number of page faults in the batch
+     */
+    int AccessMany(RefStringView pages)
+    {
+        int page_faults = 0;
+        for (auto i = pages.begin(); i != pages.end(); ++i)
+        {
+            page_faults += !Access(*i).hit;
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Reset swaps every page out and restarts virtual time
+     */
+    void Reset()
+    {
+        circle_.Reset(num_frames_);
+        frame_of_.Clear();
+        std::fill(referenced_.begin(), referenced_.end(), 0);
+        hand_ = circle_.End(0);
+        used_frames_ = 0;
+        now_ = 0;
+    }
+
+    int Window() const { return window_; }
+    int NumFrames() const { return num_frames_; }
+    int Size() const { return used_frames_; }
+    bool Contains(int page) const { return frame_of_.Find(page) >= 0; }
+
+private:
+    // Pages the hand looks at before growing into a free frame
+    enum { kGrowSweep = 16 };
+
+    /*!
+     * \brief SweepHand takes the hand around the circle at most once, or
+     * just kGrowSweep pages while there is a free frame
+     * \return The frame to replace, or -1 if the pages looked at are in the
+     * working set and there is a free frame to grow into
+     */
+    int SweepHand()
+    {
+        bool can_grow = used_frames_ < num_frames_;
+        int steps = can_grow ? std::min<int>(used_frames_, kGrowSweep) : used_frames_;
+        int oldest = -1;
+        for (int step = 0; step < steps; ++step)
+        {
+            // The sentinel is not a frame, the circle closes over it
+            if (hand_ == circle_.End(0))
+            {
+                hand_ = circle_.Front(0);
+            }
+
+            int frame = hand_;
+            uint64_t& word = referenced_[frame >> 6];
+            uint64_t bit = 1ull << (frame & 63);
+            if (word & bit)
+            {
+                word &= ~bit;
+                last_use_[frame] = now_;
+            }
+            else if (now_ - last_use_[frame] > (uint64_t) window_)
+            {
+                return frame;
+            }
+
+            if (oldest < 0 || last_use_[frame] < last_use_[oldest])
+            {
+                oldest = frame;
+            }
+            hand_ = circle_.Next(frame);
+        }
+
+        return can_grow ? -1 : oldest;
+    }
+
+    // The window tau
+    int window_;
+    // Number of frames in the system
+    int num_frames_;
+    // The resident frames in hand order
+    IndexedList circle_;
+    // Frame the hand points at, may be the sentinel of circle_
+    int hand_;
+    // Page held in every frame and the virtual time it was last known used
+    std::vector<int> frame_pages_;
+    std::vector<uint64_t> last_use_;
+    // Reference bit of every frame, 64 to a word
+    std::vector<uint64_t> referenced_;
+    // Resident page -> frame it is held in
+    PageMap frame_of_;
+    // Number of frames handed out so far
+    int used_frames_;
+    // Virtual time, the number of requests so far
+    uint64_t now_;
+};
+
+/*!
+ * \brief The WSClockPageReplacement class is used to calculate the number of
+ * page faults in a system using the WSClock algorithm. See WSClockPageCache.
+ * Besides the faults it records the resident set size after every request.
+ */
+class WSClockPageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief WSClockPageReplacement constructs a WSClockPageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system
+     * \param window The working set window tau, in requests
+     */
+    WSClockPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames, int window)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames), window_(window) {}
+
+    WSClockPageReplacement(RefStringView ref_string, int num_pages, int num_frames, int window)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames), window_(window) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of page faults using
+     * the WSClock algorithm and records the resident set sizes
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        WSClockPageCache cache(window_, num_frames_, PageSet::DensePagesFor(ref_string_));
+        timeline_.Clear();
+        timeline_.Reserve(ref_string_.size());
+
+        int page_faults = 0;
+        for (auto i = ref_string_.begin(); i != ref_string_.end(); ++i)
+        {
+            page_faults += !cache.Access(*i).hit;
+            timeline_.Record(cache.Size());
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Timeline returns the resident set sizes of the last
+     * CalculatePageFaults
+     */
+    const ResidentSetTimeline& Timeline() const { return timeline_; }
+
+private:
+    int window_;
+    ResidentSetTimeline timeline_;
+};
+
+/*!
+ * \brief The PFFPageCache class is the Page Fault Frequency algorithm of Chu
+ * and Opderbeck as an online cache. The allocation adapts to how often the
+ * program faults. When a fault comes sooner than threshold requests after
+ * the previous one the program needs more memory and the page simply gets a
+ * new frame. When it comes later the program is doing fine with less, so
+ * every page that was not requested since the previous fault is swapped out
+ * before the new page comes in.
+ *
+ * The pages are kept in an LRU list, which makes the pages not requested
+ * since the previous fault a prefix of it, so shrinking costs one step per
+ * page swapped out and every request is O(1) amortised. The allocation is
+ * capped at the frames of the system, past which the least recently used
+ * page is replaced.
+ */
+class PFFPageCache
+{
+public:
+    /*!
+     * \brief PFFPageCache constructs an empty cache
+     * \param threshold Inter-fault time, in requests, above which the
+     * allocation shrinks
+     * \param num_frames Number of frames in the system, the most the
+     * allocation can grow to
+     * \param dense_pages Pages below this are looked up in an array, pass 0
+     * when the page ids are not bounded
+     */
+    PFFPageCache(int threshold, int num_frames, int dense_pages = 0)
+        : frame_of_(dense_pages)
+    {
+        threshold_ = threshold < 0 ? 0 : threshold;
+        num_frames_ = num_frames < 0 ? 0 : num_frames;
+        frame_pages_.assign(num_frames_, 0);
+        last_use_.assign(num_frames_, 0);
+        frame_of_.Reserve(dense_pages > 0 ? 0 : num_frames_ * 2);
+        Reset();
+    }
+
+    /*!
+     * \brief Access requests a page, swapping it in if it is not in memory
+     * \param page Requested page
+     * \return Whether the request hit and which page was swapped out, if any.
+     * A fault can shrink the allocation by several pages at once, in which
+     * case evicted_page is the last of them, see LastNumEvicted.
+     */
+    PageAccessResult Access(int page)
+    {
+        PageAccessResult result = {true, false, 0};
+        now_ += 1;
+        int frame = frame_of_.Find(page);
+
+        if (frame >= 0)
+        {
+            last_use_[frame] = now_;
+            recency_.MoveToBack(0, frame);
+            return result;
+        }
+
+        result.hit = false;
+        last_num_evicted_ = 0;
+        if (num_frames_ == 0)
+        {
+            last_fault_ = now_;
+            return result;
+        }
+
+        // A long time without faults, so drop every page that was not
+        // requested since the previous one
+        if (now_ - last_fault_ > (uint64_t) threshold_)
+        {
+            while (!recency_.Empty(0) && last_use_[recency_.Front(0)] < last_fault_)
+            {
+                Evict(result);
+            }
+        }
+        last_fault_ = now_;
+
+        // Grow into a free frame, or replace the least recently used page
+        // once the allocation has every frame
+        if (free_frames_.empty())
+        {
+            Evict(result);
+        }
+        frame = free_frames_.back();
+        free_frames_.pop_back();
+
+        frame_pages_[frame] = page;
+        frame_of_.Set(page, frame);
+        last_use_[frame] = now_;
+        recency_.PushBack(0, frame);
+        return result;
+    }
+
+    /*!
+     * \brief AccessMany requests a batch of pages in order
+     * \param pages Requested pages
+     * \return The number of page faults in the batch
+     */
+    int AccessMany(RefStringView pages)
+    {
+        int page_faults = 0;
+        for (auto i = pages.begin(); i != pages.end(); ++i)
+        {
+            page_faults += !Access(*i).hit;
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Reset swaps every page out and restarts virtual time
+     */
+    void Reset()
+    {
+        recency_.Reset(num_frames_);
+        frame_of_.Clear();
+        free_frames_.clear();
+        for (int frame = num_frames_ - 1; frame >= 0; --frame)
+        {
+            free_frames_.push_back(frame);
+        }
+        now_ = 0;
+        last_fault_ = 0;
+        last_num_evicted_ = 0;
+    }
+
+    int Threshold() const { return threshold_; }
+    int NumFrames() const { return num_frames_; }
+    int Size() const { return recency_.Size(0); }
+    bool Contains(int page) const { return frame_of_.Find(page) >= 0; }
+
+    /*!
+     * \brief LastNumEvicted returns how many pages the last fault swapped out
+     */
+    int LastNumEvicted() const { return last_num_evicted_; }
+
+private:
+    /*!
+     * \brief Evict swaps out the least recently used page
+     */
+    void Evict(PageAccessResult& result)
+    {
+        int frame = recency_.Front(0);
+        recency_.Remove(frame);
+        frame_of_.Erase(frame_pages_[frame]);
+        free_frames_.push_back(frame);
+
+        result.evicted = true;
+        result.evicted_page = frame_pages_[frame];
+        last_num_evicted_ += 1;
+    }
+
+    // Inter-fault time above which the allocation shrinks
+    int threshold_;
+    // Number of frames in the system
+    int num_frames_;
+    // Allocated frames, least recently used first
+    IndexedList recency_;
+    // Frames that are not allocated
+    std::vector<int> free_frames_;
+    // Page held in every frame and the virtual time of its last request
+    std::vector<int> frame_pages_;
+    std::vector<uint64_t> last_use_;
+    // Resident page -> frame it is held in
+    PageMap frame_of_;
+    // Virtual time, the number of requests so far, and the time of the
+    // previous fault
+    uint64_t now_;
+    uint64_t last_fault_;
+    // Pages swapped out by the last fault
+    int last_num_evicted_;
+};
+
+/*!
+ * \brief The PFFPageReplacement class is used to calculate the number of page
+ * faults in a system using the Page Fault Frequency algorithm. See
+ * PFFPageCache. Besides the faults it reports the average and peak number
+ * of frames allocated, in a single pass that keeps no per request state.
+ */
+class PFFPageReplacement: public AbstractPageReplacement
+{
+public:
+    /*!
+     * \brief PFFPageReplacement constructs a PFFPageReplacement
+     * object with a the given values. This just calls the super constructor
+     * in AbstractPageReplacement.
+     * \param ref_string Ordered string of frame requests
+     * \param num_pages Number of pages in the system
+     * \param num_frames Number of frames in the system, the most that can be
+     * allocated
+     * \param threshold Inter-fault time, in requests, above which the
+     * allocation shrinks
+     * \param keep_timeline Whether to keep the allocation after every request
+     */
+    PFFPageReplacement(std::vector<int>& ref_string, int num_pages, int num_frames, int threshold,
+                       bool keep_timeline = false)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames),
+      threshold_(threshold), timeline_(keep_timeline) {}
+
+    PFFPageReplacement(RefStringView ref_string, int num_pages, int num_frames, int threshold,
+                       bool keep_timeline = false)
+    :AbstractPageReplacement(ref_string, num_pages, num_frames),
+      threshold_(threshold), timeline_(keep_timeline) {}
+
+    /*!
+     * \brief CalculatePageFaults calculates the number of page faults using
+     * the Page Fault Frequency algorithm and records the allocation
+     * \return The number of page faults calculated when using this algorithm
+     */
+    int CalculatePageFaults()
+    {
+        PFFPageCache cache(threshold_, num_frames_, PageSet::DensePagesFor(ref_string_));
+        timeline_.Clear();
+        timeline_.Reserve(ref_string_.size());
+
+        int page_faults = 0;
+        for (auto i = ref_string_.begin(); i != ref_string_.end(); ++i)
+        {
+            page_faults += !cache.Access(*i).hit;
+            timeline_.Record(cache.Size());
+        }
+        return page_faults;
+    }
+
+    /*!
+     * \brief Timeline returns the average and peak allocation of the last
+     * CalculatePageFaults, and every allocation if it was asked to keep them
+     */
+    const ResidentSetTimeline& Timeline() const { return timeline_; }
+    double AverageFrames() const { return timeline_.Average(); }
+    int PeakFrames() const { return timeline_.Peak(); }
+
+private:
+    int threshold_;
+    ResidentSetTimeline timeline_;
+};
+
+/*!
+ * \brief The PageReplacementAlgorithm enum names every algorithm that can be
+ * created with CreatePageReplacement
+ */
+enum class PageReplacementAlgorithm
+{
+    FIFO,
+    LRU,
+    OPT,
+    HashedLRU,
+    HeapOPT,
+    RingFIFO,
+    Clock,
+    ARC,
+    LIRS,
+    WTinyLFU,
+    TwoQ,
+    SLRU,
+    LFU,
+    S3FIFO,
+    Sieve
+};
+
+/*!
+ * \brief The PageReplacementAlgorithmInfo struct describes an algorithm
+ * to the user. The id is a short name used on command lines and in result
+ * files, the name is what is shown in the GUI.
+ */
+struct PageReplacementAlgorithmInfo
+{
+    PageReplacementAlgorithm algorithm;
+    const char* id;
+    const char* name;
+};
+
+/*!
+ * \brief PageReplacementAlgorithms lists every algorithm in the order they
+ * are shown to the user
+ */
+inline const std::vector<PageReplacementAlgorithmInfo>& PageReplacementAlgorithms()
+{
+    static const std::vector<PageReplacementAlgorithmInfo> algorithms = {
+        {PageReplacementAlgorithm::FIFO, "fifo", "FIFO"},
+        {PageReplacementAlgorithm::LRU, "lru", "LRU"},
+        {PageReplacementAlgorithm::OPT, "opt", "OPT"},
+        {PageReplacementAlgorithm::HashedLRU, "lru-hashed", "LRU (Hashed)"},
+        {PageReplacementAlgorithm::HeapOPT, "opt-heap", "OPT (Heap)"},
+        {PageReplacementAlgorithm::RingFIFO, "fifo-ring", "FIFO (Ring)"},
+        {PageReplacementAlgorithm::Clock, "clock", "CLOCK"},
+        {PageReplacementAlgorithm::ARC, "arc", "ARC"},
+        {PageReplacementAlgorithm::LIRS, "lirs", "LIRS"},
+        {PageReplacementAlgorithm::WTinyLFU, "w-tinylfu", "W-TinyLFU"},
+        {PageReplacementAlgorithm::TwoQ, "2q", "2Q"},
+        {PageReplacementAlgorithm::SLRU, "slru", "SLRU"},
+        {PageReplacementAlgorithm::LFU, "lfu", "LFU"},
+        {PageReplacementAlgorithm::S3FIFO, "s3-fifo", "S3-FIFO"},
+        {PageReplacementAlgorithm::Sieve, "sieve", "SIEVE"},
+    };
+    return algorithms;
+}
+
+/*!
+ * \brief PageReplacementAlgorithmInfoOf finds the description of an algorithm
+ */
+inline const PageReplacementAlgorithmInfo& PageReplacementAlgorithmInfoOf(PageReplacementAlgorithm algorithm)
+{
+    const std::vector<PageReplacementAlgorithmInfo>& algorithms = PageReplacementAlgorithms();
+    for (auto i = algorithms.begin(); i != algorithms.end(); ++i)
+    {
+        if (i->algorithm == algorithm)
+        {
+            return *i;
+        }
+    }
+    return algorithms.front();
+}
+
+/*!
+ * \brief FindPageReplacementAlgorithm looks an algorithm up by its id
+ * \param id Id of the algorithm, for example "lru"
+ * \param algorithm Set to the algorithm when it is found
+ * \return True if there is an algorithm with that id
+ */
+inline bool FindPageReplacementAlgorithm(const std::string& id, PageReplacementAlgorithm& algorithm)
+{
+    const std::vector<PageReplacementAlgorithmInfo>& algorithms = PageReplacementAlgorithms();
+    for (auto i = algorithms.begin(); i != algorithms.end(); ++i)
+    {
+        if (id == i->id)
+        {
+            algorithm = i->algorithm;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ * \brief CreatePageReplacement creates a page replacement algorithm on top of
+ * a reference string that is owned by the caller. The reference string must
+ * already be clean and must outlive the returned object.
+ * \param algorithm Algorithm to create
+ * \param ref_string Cleaned, ordered list of frame requests
+ * \param num_pages Number of pages in the system
+ * \param num_frames Number of frames in the system
+ * \return The algorithm, ready to calculate its page faults
+ */
+inline std::unique_ptr<AbstractPageReplacement> CreatePageReplacement(PageReplacementAlgorithm algorithm,
+                                                                      RefStringView ref_string,
+                                                                      int num_pages, int num_frames)
+{
+    AbstractPageReplacement* page_replacement = nullptr;
+
+    switch (algorithm)
+    {
+        case PageReplacementAlgorithm::FIFO:
+            page_replacement = new FIFOPageReplacement(ref_string, num_pages, num_frames);
+            break;
+        case PageReplacementAlgorithm::LRU:
+            page_replacement = new LRUPageReplacement(ref_string, num_pages, num_frames);
+            break;
+        case PageReplacementAlgorithm::OPT:
+            page_replacement = new OPTPageReplacement(ref_string, num_pages, num_frames);
+            break;
+        case PageReplacementAlgorithm::HashedLRU:
+            page_replacement = new HashedLRUPageReplacement(ref_string, num_pages, num_frames);
+            break;
+        case PageReplacementAlgorithm::HeapOPT:
+            page_replacement = new HeapOPTPageReplacement(ref_string, num_pages, num_frames);
+            break;
+        case PageReplacementAlgorithm::RingFIFO:
+            page_replacement = new RingFIFOPageReplacement(ref_string, num_pages, num_frames);
+            break;
+        case PageReplacementAlgorithm::Clock:
+            page_replacement = new ClockPageReplacement(ref_string, num_pages, num_frames);
+            break;
+        case PageReplacementAlgorithm::ARC:
+            page_replacement = new ARCPageReplacement(ref_string, num_pages, num_frames);
+            break;
+        case PageReplacementAlgorithm::LIRS:
+            page_replacement = new LIRSPageReplacement(ref_string, num_pages, num_frames);
+            break;
+        case PageReplacementAlgorithm::WTinyLFU:
+            page_replacement = new WTinyLFUPageReplacement(ref_string, num_pages, num_frames);
+            break;
+        case PageReplacementAlgorithm::TwoQ:
+            page_replacement = new TwoQPageReplacement(ref_string, num_pages, num_frames);
+            break;
+        case PageReplacementAlgorithm::SLRU:
+            page_replacement = new SLRUPageReplacement(ref_string, num_pages, num_frames);
+            break;
+        case PageReplacementAlgorithm::LFU:
+            page_replacement = new LFUPageReplacement(ref_string, num_pages, num_frames);
+            break;
+        case PageReplacementAlgorithm::S3FIFO:
+            page_replacement = new S3FIFOPageReplacement(ref_string, num_pages, num_frames);
+            break;
+        case PageReplacementAlgorithm::Sieve:
+            page_replacement = new SievePageReplacement(ref_string, num_pages, num_frames);
+            break;
+    }
+
+    return std::unique_ptr<AbstractPageReplacement>(page_replacement);
+}
+
+#endif // PAGEREPLACEMENT_H
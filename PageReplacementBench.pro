@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Benchmark suite for the page replacement
+# algorithms. Prints its results as JSON.
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = PageReplacementBench
+TEMPLATE = app
+
+CONFIG += console c++11 thread release
+CONFIG -= app_bundle qt debug
+
+unix: LIBS += -pthread
+
+SOURCES += \
+        benchmark.cpp
+
+HEADERS += \
+        PageReplacement.h \
+        RefStringGenerator.h
@@ -0,0 +1,28 @@
+#-------------------------------------------------
+#
+# Headless command line front end for the page
+# replacement algorithms. Does not need Qt at runtime.
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = PageReplacementCLI
+TEMPLATE = app
+
+CONFIG += console c++11 thread
+CONFIG -= app_bundle qt
+
+unix: LIBS += -pthread
+
+SOURCES += \
+        climain.cpp
+
+HEADERS += \
+        AddressTrace.h \
+        LocalityProfiler.h \
+        PageFaultSweep.h \
+        PageReplacement.h \
+        RefStringGenerator.h \
+        RefStringParser.h \
+        TraceFile.h
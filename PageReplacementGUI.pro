@@ -25,12 +25,19 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 
 SOURCES += \
+        graphwindow.cpp \
         main.cpp \
         mainwindow.cpp
 
 HEADERS += \
+        graphwindow.h \
         mainwindow.h \
-        PageReplacement.h
+        LocalityProfiler.h \
+        PageFaultSweep.h \
+        PageReplacement.h \
+        RefStringGenerator.h \
+        RefStringParser.h \
+        TraceFile.h
 FORMS += \
         mainwindow.ui
 
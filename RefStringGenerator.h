@@ -0,0 +1,445 @@
+#ifndef REFSTRINGGENERATOR_H
+#define REFSTRINGGENERATOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*!
+ * \brief The Xoshiro256 class is the xoshiro256** pseudo random number
+ * generator by Blackman and Vigna. It is a handful of shifts, rotates and
+ * xors per number, passes the usual statistical test suites and behaves the
+ * same on every platform, unlike rand().
+ */
+class Xoshiro256
+{
+public:
+    /*!
+     * \brief Xoshiro256 seeds the generator from one 64 bit seed. The seed is
+     * spread over the 256 bits of state with SplitMix64 as the authors
+     * recommend, so nearby seeds give unrelated sequences.
+     * \param seed Seed of the sequence
+     */
+    explicit Xoshiro256(uint64_t seed = 0)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            state_[i] = SplitMix64(seed);
+        }
+    }
+
+    /*!
+     * \brief Xoshiro256 seeds an independent stream of a sequence. Streams
+     * only depend on (seed, stream), which is what lets blocks of a
+     * reference string be generated on any thread in any order.
+     * \param seed Seed of the sequence
+     * \param stream Index of the stream
+     */
+    Xoshiro256(uint64_t seed, uint64_t stream)
+    {
+        uint64_t mixed = seed ^ (stream * 0xD1B54A32D192ED03ull);
+        SplitMix64(mixed);
+        for (int i = 0; i < 4; ++i)
+        {
+            state_[i] = SplitMix64(mixed);
+        }
+    }
+
+    /*!
+     * \brief Next returns the next 64 random bits
+     */
+    uint64_t Next()
+    {
+        const uint64_t result = Rotl(state_[1] * 5, 7) * 9;
+        const uint64_t t = state_[1] << 17;
+
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = Rotl(state_[3], 45);
+
+        return result;
+    }
+
+    /*!
+     * \brief NextBelow returns an unbiased random number in [0, bound) using
+     * Lemire's multiply and shift method. Unlike rand() % bound there is no
+     * modulo bias, and the division only happens on the rare rejection path.
+     * \param bound Exclusive upper bound, must be at least 1
+     */
+    uint32_t NextBelow(uint32_t bound)
+    {
+        uint64_t product = (Next() >> 32) * (uint64_t) bound;
+        uint32_t low = (uint32_t) product;
+
+        if (low < bound)
+        {
+            const uint32_t threshold = (uint32_t) (-bound) % bound;
+            while (low < threshold)
+            {
+                product = (Next() >> 32) * (uint64_t) bound;
+                low = (uint32_t) product;
+            }
+        }
+
+        return (uint32_t) (product >> 32);
+    }
+
+    /*!
+     * \brief NextDouble returns a uniform random number in [0, 1)
+     */
+    double NextDouble()
+    {
+        return (double) (Next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    /*!
+     * \brief SplitMix64 advances a 64 bit counter and returns a well mixed
+     * hash of it
+     */
+    static uint64_t SplitMix64(uint64_t& counter)
+    {
+        uint64_t z = (counter += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+private:
+    static uint64_t Rotl(uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t state_[4];
+};
+
+/*!
+ * \brief The RefStringGenerator class generates random reference strings where
+ * every page is uniform in [0, upper_bound) and no two consecutive pages are
+ * equal.
+ *
+ * The string is cut into fixed size blocks that each get their own Xoshiro256
+ * stream, so the output only depends on the seed. Generating on one thread or
+ * on many gives exactly the same reference string.
+ */
+class RefStringGenerator
+{
+public:
+    // Number of pages generated from one random stream
+    static const size_t kBlockSize = 1 << 16;
+
+    /*!
+     * \brief Generate generates a reference string on the calling thread
+     * \param size Size of the reference string to generate
+     * \param upper_bound Upper bound of the reference string
+     * \param seed Seed of the reference string
+     * \return Randomly filled vector with no equivalent sequential elements
+     */
+    static std::vector<int> Generate(size_t size, int upper_bound, uint64_t seed)
+    {
+        return GenerateParallel(size, upper_bound, seed, 1);
+    }
+
+    /*!
+     * \brief GenerateParallel generates a reference string using several
+     * threads. The result is the same as Generate with the same seed.
+     * \param size Size of the reference string to generate
+     * \param upper_bound Upper bound of the reference string
+     * \param seed Seed of the reference string
+     * \param num_threads Number of threads, 0 uses every hardware thread
+     * \return Randomly filled vector with no equivalent sequential elements
+     */
+    static std::vector<int> GenerateParallel(size_t size, int upper_bound, uint64_t seed,
+                                             unsigned num_threads)
+    {
+        std::vector<int> ref_string(size);
+        Fill(ref_string.data(), size, upper_bound, seed, num_threads);
+        return ref_string;
+    }
+
+    /*!
+     * \brief Fill generates a reference string into a caller supplied buffer
+     * \param pages Buffer of at least size pages
+     * \param size Size of the reference string to generate
+     * \param upper_bound Upper bound of the reference string
+     * \param seed Seed of the reference string
+     * \param num_threads Number of threads, 0 uses every hardware thread
+     */
+    static void Fill(int* pages, size_t size, int upper_bound, uint64_t seed,
+                     unsigned num_threads = 1)
+    {
+        if (size == 0)
+        {
+            return;
+        }
+
+        // With fewer than two pages there is no way to avoid repeats, so the
+        // only possible answer is a string of zeros
+        if (upper_bound < 2)
+        {
+            std::fill(pages, pages + size, 0);
+            return;
+        }
+
+        // With exactly two pages the string has to alternate, so only the
+        // first page is random
+        if (upper_bound == 2)
+        {
+            int page = (int) Xoshiro256(seed, 0).NextBelow(2);
+            for (size_t i = 0; i < size; ++i, page ^= 1)
+            {
+                pages[i] = page;
+            }
+            return;
+        }
+
+        const size_t num_blocks = (size + kBlockSize - 1) / kBlockSize;
+
+        if (num_threads == 0)
+        {
+            num_threads = std::thread::hardware_concurrency();
+        }
+        if (num_threads > num_blocks)
+        {
+            num_threads = (unsigned) num_blocks;
+        }
+
+        // Every block is independent so threads just take the next one
+        std::atomic<size_t> next_block(0);
+        auto worker = [&]() {
+            for (size_t block = next_block++; block < num_blocks; block = next_block++)
+            {
+                size_t first = block * kBlockSize;
+                size_t count = size - first < kBlockSize ? size - first : kBlockSize;
+                FillBlock(pages + first, count, upper_bound, seed, block);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned t = 1; t < num_threads; ++t)
+        {
+            threads.push_back(std::thread(worker));
+        }
+        worker();
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        // A block does not know how the block before it ends, so its first
+        // page can repeat the last page of the previous block. Redraw those
+        // pages from what is left once both neighbours are excluded.
+        for (size_t block = 1; block < num_blocks; ++block)
+        {
+            size_t first = block * kBlockSize;
+            if (pages[first] != pages[first - 1])
+            {
+                continue;
+            }
+
+            Xoshiro256 rng(seed, num_blocks + block);
+            int after = first + 1 < size ? pages[first + 1] : pages[first - 1];
+            pages[first] = DrawExcluding(rng, upper_bound, pages[first - 1], after);
+        }
+    }
+
+    /*!
+     * \brief The Workload enum lists the shapes of synthetic reference strings
+     * GenerateWorkload can make
+     */
+    enum class Workload
+    {
+        // Every page is equally likely
+        Uniform,
+        // Page k is requested with probability proportional to 1 / (k + 1)^s,
+        // so a few pages are very hot and most are cold
+        Zipf,
+        // The pages are requested in order over and over, 0, 1, ..., upper_bound - 1,
+        // which is the worst case for LRU and FIFO
+        Loop,
+        // A hot tenth of the pages is requested at random, interrupted by
+        // sequential scans through the cold pages that pollute the cache
+        Scan
+    };
+
+    /*!
+     * \brief WorkloadName returns the name of a workload as used in results
+     */
+    static const char* WorkloadName(Workload workload)
+    {
+        switch (workload)
+        {
+            case Workload::Uniform: return "uniform";
+            case Workload::Zipf: return "zipf";
+            case Workload::Loop: return "loop";
+            case Workload::Scan: return "scan";
+        }
+        return "";
+    }
+
+    /*!
+     * \brief FindWorkload looks a workload up by its name
+     * \return True if there is a workload with that name
+     */
+    static bool FindWorkload(const std::string& name, Workload& workload)
+    {
+        const Workload workloads[] = {Workload::Uniform, Workload::Zipf, Workload::Loop, Workload::Scan};
+        for (Workload candidate : workloads)
+        {
+            if (name == WorkloadName(candidate))
+            {
+                workload = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*!
+     * \brief GenerateWorkload generates a reference string of a given shape.
+     * Like Generate no two consecutive pages are equal and the same seed always
+     * gives the same reference string.
+     * \param workload Shape of the reference string
+     * \param size Size of the reference string to generate
+     * \param upper_bound Upper bound of the reference string
+     * \param seed Seed of the reference string
+     * \param zipf_exponent Skew s of the Zipf workload
+     * \return The generated reference string
+     */
+    static std::vector<int> GenerateWorkload(Workload workload, size_t size, int upper_bound,
+                                             uint64_t seed, double zipf_exponent = 0.99)
+    {
+        if (workload == Workload::Uniform || upper_bound <= 2)
+        {
+            return Generate(size, upper_bound, seed);
+        }
+
+        std::vector<int> ref_string(size);
+        Xoshiro256 rng(seed);
+
+        if (workload == Workload::Zipf)
+        {
+            // Cumulative distribution over the page ranks, a page is drawn by
+            // binary searching it with a uniform number
+            std::vector<double> cdf(upper_bound);
+            double total = 0;
+            for (int k = 0; k < upper_bound; ++k)
+            {
+                total += 1.0 / std::pow(k + 1.0, zipf_exponent);
+                cdf[k] = total;
+            }
+
+            int previous = -1;
+            for (size_t i = 0; i < size; ++i)
+            {
+                int page;
+                do
+                {
+                    double u = rng.NextDouble() * total;
+                    page = (int) (std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+                    page = page < upper_bound ? page : upper_bound - 1;
+                } while (page == previous);
+
+                ref_string[i] = page;
+                previous = page;
+            }
+        }
+        else if (workload == Workload::Loop)
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                ref_string[i] = (int) (i % (size_t) upper_bound);
+            }
+        }
+        else
+        {
+            // Hot phases of 4 * hot requests alternate with scans of 2 * hot
+            // cold pages, the scans carry on where the previous one stopped
+            const int hot = std::max(2, upper_bound / 10);
+            const int cold = upper_bound - hot;
+            int scan_position = 0;
+            int previous = -1;
+            size_t i = 0;
+
+            while (i < size)
+            {
+                for (int k = 0; k < 4 * hot && i < size; ++k)
+                {
+                    bool previous_hot = previous >= 0 && previous < hot;
+                    int page = (int) rng.NextBelow((uint32_t) (previous_hot ? hot - 1 : hot));
+                    page += previous_hot && page >= previous;
+                    ref_string[i++] = page;
+                    previous = page;
+                }
+
+                for (int k = 0; k < 2 * hot && cold > 0 && i < size; ++k)
+                {
+                    int page = hot + scan_position;
+                    scan_position = scan_position + 1 == cold ? 0 : scan_position + 1;
+                    if (page == previous)
+                    {
+                        continue;
+                    }
+                    ref_string[i++] = page;
+                    previous = page;
+                }
+            }
+        }
+
+        return ref_string;
+    }
+
+private:
+    /*!
+     * \brief FillBlock generates one block from its own stream. Instead of
+     * retrying when a page repeats the previous one, a page is drawn from the
+     * upper_bound - 1 other pages directly and shifted past the previous page,
+     * which is just as uniform but never loops and never branches.
+     */
+    static void FillBlock(int* pages, size_t count, int upper_bound, uint64_t seed, size_t block)
+    {
+        Xoshiro256 rng(seed, block);
+        const uint32_t others = (uint32_t) upper_bound - 1;
+
+        int previous = (int) rng.NextBelow((uint32_t) upper_bound);
+        pages[0] = previous;
+
+        for (size_t i = 1; i < count; ++i)
+        {
+            int page = (int) rng.NextBelow(others);
+            page += page >= previous;
+            pages[i] = page;
+            previous = page;
+        }
+    }
+
+    /*!
+     * \brief DrawExcluding draws a uniform page in [0, upper_bound) that is
+     * neither a nor b. a and b may be equal. upper_bound must be at least 3.
+     */
+    static int DrawExcluding(Xoshiro256& rng, int upper_bound, int a, int b)
+    {
+        int low = std::min(a, b);
+        int high = std::max(a, b);
+        int excluded = low == high ? 1 : 2;
+
+        int page = (int) rng.NextBelow((uint32_t) (upper_bound - excluded));
+        page += page >= low;
+        if (excluded == 2)
+        {
+            page += page >= high;
+        }
+        return page;
+    }
+};
+
+#endif // REFSTRINGGENERATOR_H
@@ -0,0 +1,440 @@
+#ifndef REFSTRINGPARSER_H
+#define REFSTRINGPARSER_H
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "PageReplacement.h"
+
+/*
+ * Parser for reference strings written as text: integer page ids separated
+ * by commas and whitespace in any mix, "1, 2,3\n 42". An optional minus sign
+ * may start a page id. Runs of separators count as one, so empty tokens are
+ * not errors. Any other token (a letter, "1.5", "7-", a page id that does
+ * not fit an int) is malformed: it is skipped and reported with its byte
+ * offset, so the rest of the string is still usable.
+ *
+ * Digits are found and converted eight bytes at a time with SWAR (SIMD
+ * within a register) arithmetic on 64 bit words. Large inputs are split
+ * into chunks at separators and the chunks are parsed on their own threads.
+ */
+
+/*!
+ * \brief The RefStringParseError struct describes one malformed token
+ */
+struct RefStringParseError
+{
+    // Byte offset of the token from the start of the text and its length
+    uint64_t offset;
+    size_t length;
+    // The start of the token, enough to show what was wrong with it
+    std::string quote;
+};
+
+/*!
+ * \brief The RefStringParser class parses text into a reference string and
+ * keeps the malformed tokens it found along the way
+ */
+class RefStringParser
+{
+public:
+    // Only this many malformed tokens are kept, the rest are only counted
+    enum { kMaxErrors = 32 };
+
+    RefStringParser() : num_malformed_(0) {}
+
+    /*!
+     * \brief Parse parses text on the calling thread, appending every page
+     * id to ref_string
+     * \param text Text to parse
+     * \param size Size of the text in bytes
+     * \param ref_string Receives the page ids
+     * \return True if there was no malformed token
+     */
+    bool Parse(const char* text, size_t size, std::vector<int>& ref_string)
+    {
+        Reset();
+        ParseWindow(text, size, 0, ref_string, 1);
+        return num_malformed_ == 0;
+    }
+
+    bool Parse(const std::string& text, std::vector<int>& ref_string)
+    {
+        return Parse(text.data(), text.size(), ref_string);
+    }
+
+    /*!
+     * \brief ParseParallel parses text split into chunks on several threads.
+     * The result is the same as Parse().
+     * \param num_threads Number of threads, 0 uses every hardware thread
+     * \return True if there was no malformed token
+     */
+    bool ParseParallel(const char* text, size_t size, std::vector<int>& ref_string, unsigned num_threads = 0)
+    {
+        Reset();
+        ParseWindow(text, size, 0, ref_string, num_threads);
+        return num_malformed_ == 0;
+    }
+
+    /*!
+     * \brief ParseWindow parses one window of a text too large to hold at
+     * once, keeping the malformed tokens of the windows before it. Windows
+     * must be handed over in order and split between tokens. Text shorter
+     * than a few chunks is parsed on the calling thread.
+     * \param text Text of the window
+     * \param size Size of the window in bytes
+     * \param base Offset of the window from the start of the whole text
+     * \param ref_string Receives the page ids
+     * \param num_threads Number of threads, 0 uses every hardware thread
+     */
+    void ParseWindow(const char* text, size_t size, uint64_t base, std::vector<int>& ref_string,
+                     unsigned num_threads = 0)
+    {
+        if (num_threads == 0)
+        {
+            num_threads = std::thread::hardware_concurrency();
+        }
+
+        // A chunk should take far longer to parse than a thread takes to start
+        size_t max_chunks = size / (1 << 20);
+        if (num_threads > max_chunks)
+        {
+            num_threads = (unsigned) max_chunks;
+        }
+        if (num_threads <= 1)
+        {
+            std::vector<RefStringParseError> errors;
+            uint64_t num_malformed = 0;
+            ParseChunk(text, 0, size, ref_string, errors, num_malformed);
+            AddErrors(text, base, errors, num_malformed);
+            return;
+        }
+
+        // Chunks end at a separator so no token is cut in two
+        std::vector<size_t> bounds(1, 0);
+        for (unsigned t = 1; t < num_threads; ++t)
+        {
+            size_t bound = size * t / num_threads;
+            if (bound < bounds.back())
+            {
+                bound = bounds.back();
+            }
+            while (bound < size && !IsSeparator(text[bound]))
+            {
+                ++bound;
+            }
+            bounds.push_back(bound);
+        }
+        bounds.push_back(size);
+
+        std::vector<std::vector<int>> pages(num_threads);
+        std::vector<std::vector<RefStringParseError>> errors(num_threads);
+        std::vector<uint64_t> num_malformed(num_threads, 0);
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < num_threads; ++t)
+        {
+            threads.push_back(std::thread([&, t]() {
+                // Guess the number of pages from the bytes so the vector
+                // rarely has to grow
+                pages[t].reserve((bounds[t + 1] - bounds[t]) / 3);
+                ParseChunk(text, bounds[t], bounds[t + 1], pages[t], errors[t], num_malformed[t]);
+            }));
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        size_t total = ref_string.size();
+        for (unsigned t = 0; t < num_threads; ++t)
+        {
+            total += pages[t].size();
+        }
+        ref_string.reserve(total);
+        for (unsigned t = 0; t < num_threads; ++t)
+        {
+            ref_string.insert(ref_string.end(), pages[t].begin(), pages[t].end());
+            AddErrors(text, base, errors[t], num_malformed[t]);
+        }
+    }
+
+    /*!
+     * \brief Reset forgets the malformed tokens found so far
+     */
+    void Reset()
+    {
+        errors_.clear();
+        num_malformed_ = 0;
+    }
+
+    /*!
+     * \brief NumMalformed returns the number of malformed tokens found since
+     * the last reset, which may be more than Errors() holds
+     */
+    uint64_t NumMalformed() const { return num_malformed_; }
+
+    /*!
+     * \brief Errors returns the first malformed tokens found since the last
+     * reset in the order they appear in the text
+     */
+    const std::vector<RefStringParseError>& Errors() const { return errors_; }
+
+    /*!
+     * \brief Error describes the malformed tokens found since the last reset
+     * \return An empty string if there were none
+     */
+    std::string Error() const
+    {
+        if (num_malformed_ == 0)
+        {
+            return std::string();
+        }
+
+        const RefStringParseError& first = errors_.front();
+        char message[128];
+        std::snprintf(message, sizeof(message), "%llu malformed page id(s), the first is \"%s\" at offset %llu",
+                      (unsigned long long) num_malformed_, first.quote.c_str(),
+                      (unsigned long long) first.offset);
+        return message;
+    }
+
+    static bool IsSeparator(char c)
+    {
+        return c == ',' || c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+    }
+
+private:
+    // Longest quote kept of a malformed token
+    enum { kMaxQuote = 32 };
+
+    /*!
+     * \brief AddErrors keeps the malformed tokens of a chunk as long as there
+     * is room, quoting them while their text is still around
+     */
+    void AddErrors(const char* text, uint64_t base, std::vector<RefStringParseError>& errors,
+                   uint64_t num_malformed)
+    {
+        for (RefStringParseError& error : errors)
+        {
+            if (errors_.size() >= kMaxErrors)
+            {
+                break;
+            }
+            size_t length = error.length < (size_t) kMaxQuote ? error.length : (size_t) kMaxQuote;
+            error.quote.assign(text + error.offset, length);
+            error.offset += base;
+            errors_.push_back(error);
+        }
+        num_malformed_ += num_malformed;
+    }
+
+    /*!
+     * \brief ParseChunk parses text[begin, end). Offsets are from text so
+     * every chunk reports the same offsets a single pass would.
+     */
+    static void ParseChunk(const char* text, size_t begin, size_t end, std::vector<int>& ref_string,
+                           std::vector<RefStringParseError>& errors, uint64_t& num_malformed)
+    {
+        size_t i = begin;
+        for (;;)
+        {
+            while (i < end && IsSeparator(text[i]))
+            {
+                ++i;
+            }
+            if (i == end)
+            {
+                return;
+            }
+
+            size_t start = i;
+            bool negative = text[i] == '-';
+            i += negative;
+
+            // Leading zeros do not count towards the length of the number
+            size_t zeros = 0;
+            while (i < end && text[i] == '0')
+            {
+                ++i;
+                ++zeros;
+            }
+
+            // Page ids are short, so most of them are found and converted by
+            // a single step. An int has at most ten digits, more than that
+            // keeps the token going so it is reported as too large.
+            uint64_t value = 0;
+            size_t digits = 0;
+            for (;;)
+            {
+                uint64_t word = LoadDigits(text + i, end - i);
+                int run = DigitRun(word);
+                if (run > 0)
+                {
+                    value = value * PowerOfTen(run) + ParseDigits(word, run);
+                    digits += run;
+                    i += run;
+                }
+                if (run < 8 || digits > 10)
+                {
+                    break;
+                }
+            }
+
+            bool valid = digits + zeros > 0 && digits <= 10 && (i == end || IsSeparator(text[i])) &&
+                    value <= (negative ? (uint64_t) INT_MAX + 1 : (uint64_t) INT_MAX);
+            if (valid)
+            {
+                ref_string.push_back((int) (negative ? -(int64_t) value : (int64_t) value));
+                continue;
+            }
+
+            while (i < end && !IsSeparator(text[i]))
+            {
+                ++i;
+            }
+            num_malformed += 1;
+            if (errors.size() < kMaxErrors)
+            {
+                RefStringParseError error;
+                error.offset = start;
+                error.length = i - start;
+                errors.push_back(error);
+            }
+        }
+    }
+
+    /*!
+     * \brief LoadDigits loads up to 8 bytes with the first byte in the lowest
+     * bits and every byte turned into its digit value, so '0'-'9' become 0-9
+     * and anything else has a value above 9. Bytes past the end are 0xff.
+     */
+    static uint64_t LoadDigits(const char* text, size_t size)
+    {
+        unsigned char bytes[8];
+        if (size >= 8)
+        {
+            std::memcpy(bytes, text, 8);
+        }
+        else
+        {
+            std::memset(bytes, 0xff, 8);
+            std::memcpy(bytes, text, size);
+        }
+
+        uint64_t word = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ || defined(_M_X64) || defined(_M_IX86)
+        std::memcpy(&word, bytes, 8);
+#else
+        for (int b = 7; b >= 0; --b)
+        {
+            word = (word << 8) | bytes[b];
+        }
+#endif
+        return word ^ 0x3030303030303030ull;
+    }
+
+    /*!
+     * \brief DigitRun returns how many of the bytes of a word from
+     * LoadDigits are digits before the first one that is not
+     */
+    static int DigitRun(uint64_t word)
+    {
+        // A byte is a digit if its high nibble is 0 and its low nibble is at
+        // most 9. Adding 6 to the low nibble carries into bit 4 exactly when
+        // it is above 9 and never carries out of the byte.
+        uint64_t high = word & 0xf0f0f0f0f0f0f0f0ull;
+        uint64_t low = ((word & 0x0f0f0f0f0f0f0f0full) + 0x0606060606060606ull) & 0x1010101010101010ull;
+        uint64_t bad = (((high | low) >> 4) + 0x7f7f7f7f7f7f7f7full) & 0x8080808080808080ull;
+        return bad == 0 ? 8 : CountTrailingZeros(bad) / 8;
+    }
+
+    /*!
+     * \brief ParseDigits converts the first run digits of a word from
+     * LoadDigits, 1 <= run <= 8. The digits are moved to the top of the word
+     * so the bytes below are leading zeros, then pairs, quads and octets of
+     * digits are combined with three multiplications.
+     */
+    static uint64_t ParseDigits(uint64_t word, int run)
+    {
+        word <<= 8 * (8 - run);
+        word = ((word & 0x0f0f0f0f0f0f0f0full) * 2561) >> 8;
+        word = ((word & 0x00ff00ff00ff00ffull) * 6553601) >> 16;
+        return ((word & 0x0000ffff0000ffffull) * 42949672960001ull) >> 32;
+    }
+
+    static uint64_t PowerOfTen(int exponent)
+    {
+        static const uint64_t powers[9] = {
+            1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+        };
+        return powers[exponent];
+    }
+
+    // First malformed tokens and how many there were
+    std::vector<RefStringParseError> errors_;
+    uint64_t num_malformed_;
+};
+
+/*!
+ * \brief ReadRefStringFile reads a text file in windows of a few MiB and
+ * parses every window in parallel. A window ends at its last separator and
+ * the token cut off after it is carried over to the next one, so memory stays
+ * bounded by the window no matter how large the file is.
+ * \param file File to read, which is left open
+ * \param parser Parser to use, which keeps the malformed tokens
+ * \param ref_string Receives the page ids
+ * \param num_threads Number of threads, 0 uses every hardware thread
+ * \return False if the file could not be read
+ */
+inline bool ReadRefStringFile(std::FILE* file, RefStringParser& parser, std::vector<int>& ref_string,
+                              unsigned num_threads = 0)
+{
+    if (num_threads == 0)
+    {
+        num_threads = std::thread::hardware_concurrency();
+    }
+
+    // Every thread gets a few MiB, far more than it takes to start it
+    std::vector<char> window((size_t) (num_threads == 0 ? 1 : num_threads) * (4 << 20));
+    parser.Reset();
+    uint64_t base = 0;
+    size_t filled = 0;
+    bool last = false;
+
+    while (!last)
+    {
+        filled += std::fread(window.data() + filled, 1, window.size() - filled, file);
+        last = filled < window.size();
+        if (last && std::ferror(file))
+        {
+            return false;
+        }
+
+        // A token longer than the whole window is cut and reported as it is
+        size_t parsed = filled;
+        if (!last)
+        {
+            while (parsed > 0 && !RefStringParser::IsSeparator(window[parsed - 1]))
+            {
+                --parsed;
+            }
+            if (parsed == 0)
+            {
+                parsed = filled;
+            }
+        }
+
+        parser.ParseWindow(window.data(), parsed, base, ref_string, num_threads);
+        std::memmove(window.data(), window.data() + parsed, filled - parsed);
+        filled -= parsed;
+        base += parsed;
+    }
+    return true;
+}
+
+#endif // REFSTRINGPARSER_H
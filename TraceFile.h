@@ -0,0 +1,1047 @@
+#ifndef TRACEFILE_H
+#define TRACEFILE_H
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "PageReplacement.h"
+
+/*
+ * Binary trace file layout. Every field is in the byte order of the host
+ * that wrote it, little endian on x86 and ARM, and the page ids start on a
+ * 4 byte boundary so the mapped file can be read as an int array directly.
+ * Nothing is byte swapped, so a trace written on a little endian host does
+ * not read on a big endian one.
+ *
+ *   offset  size  field
+ *        0     8  magic "PRTRACE1"
+ *        8     4  width of a page id in bytes (always 4)
+ *       12     4  flags (reserved, always 0)
+ *       16     8  number of page ids
+ *       24   4*n  page ids as signed 32 bit ints
+ *
+ * The writer drops consecutive duplicate pages, so the page ids in a trace
+ * file are always a clean reference string.
+ */
+
+/*!
+ * \brief The TraceFileHeader struct is the fixed size header at the start
+ * of every binary trace file
+ */
+struct TraceFileHeader
+{
+    char magic[8];
+    uint32_t page_width;
+    uint32_t flags;
+    uint64_t num_pages;
+};
+
+static const char kTraceFileMagic[8] = {'P', 'R', 'T', 'R', 'A', 'C', 'E', '1'};
+
+/*!
+ * \brief The TraceFileWriter class writes a binary trace file one chunk of
+ * pages at a time, so a trace never has to fit in memory to be converted.
+ * Consecutive duplicate pages are dropped while writing, including across
+ * chunk boundaries.
+ */
+class TraceFileWriter
+{
+public:
+    TraceFileWriter() : file_(nullptr), num_pages_(0) {}
+
+    ~TraceFileWriter()
+    {
+        Close();
+    }
+
+    /*!
+     * \brief Open creates (or truncates) the file at path and writes a
+     * placeholder header that is filled in by Close()
+     * \param path Path of the trace file
+     * \return True if the file could be created
+     */
+    bool Open(const std::string& path)
+    {
+        Close();
+        error_.clear();
+
+        file_ = std::fopen(path.c_str(), "wb");
+        if (file_ == nullptr)
+        {
+            error_ = "Could not create " + path;
+            return false;
+        }
+
+        num_pages_ = 0;
+        cleaner_.Reset();
+        buffer_.clear();
+        return WriteHeader();
+    }
+
+    /*!
+     * \brief Append writes count pages to the end of the trace
+     * \param pages First page to write
+     * \param count Number of pages to write
+     * \return True if the pages could be written
+     */
+    bool Append(const int* pages, size_t count)
+    {
+        // Copy the chunk to the back of the buffer and drop any repeated pages
+        size_t start = buffer_.size();
+        buffer_.insert(buffer_.end(), pages, pages + count);
+        buffer_.resize(start + cleaner_.Filter(buffer_.data() + start, count));
+
+        // Only hit the disk once a decent amount of pages has built up
+        if (buffer_.size() >= kBufferPages)
+        {
+            return Flush();
+        }
+        return true;
+    }
+
+    bool Append(RefStringView pages)
+    {
+        return Append(pages.data(), pages.size());
+    }
+
+    /*!
+     * \brief Close flushes the buffered pages, writes the final page count
+     * into the header and closes the file
+     * \return True if everything was written
+     */
+    bool Close()
+    {
+        if (file_ == nullptr)
+        {
+            return true;
+        }
+
+        bool ok = Flush() && std::fseek(file_, 0, SEEK_SET) == 0 && WriteHeader();
+        ok = std::fclose(file_) == 0 && ok;
+        file_ = nullptr;
+
+        if (!ok && error_.empty())
+        {
+            error_ = "Could not write the trace file";
+        }
+        return ok;
+    }
+
+    /*!
+     * \brief Error describes the last thing that went wrong
+     */
+    const std::string& Error() const { return error_; }
+
+    /*!
+     * \brief WriteTraceFile writes a whole reference string to a trace file
+     * \param path Path of the trace file
+     * \param ref_string Pages to write
+     * \return True if the file was written
+     */
+    static bool WriteTraceFile(const std::string& path, RefStringView ref_string)
+    {
+        TraceFileWriter writer;
+        return writer.Open(path) && writer.Append(ref_string) && writer.Close();
+    }
+
+private:
+    TraceFileWriter(const TraceFileWriter&) = delete;
+    TraceFileWriter& operator=(const TraceFileWriter&) = delete;
+
+    bool WriteHeader()
+    {
+        TraceFileHeader header;
+        std::memcpy(header.magic, kTraceFileMagic, sizeof(header.magic));
+        header.page_width = sizeof(int32_t);
+        header.flags = 0;
+        header.num_pages = num_pages_;
+
+        if (std::fwrite(&header, sizeof(header), 1, file_) != 1)
+        {
+            error_ = "Could not write the trace header";
+            return false;
+        }
+        return true;
+    }
+
+    bool Flush()
+    {
+        if (buffer_.empty())
+        {
+            return true;
+        }
+
+        if (std::fwrite(buffer_.data(), sizeof(int), buffer_.size(), file_) != buffer_.size())
+        {
+            error_ = "Could not write the trace pages";
+            return false;
+        }
+
+        num_pages_ += buffer_.size();
+        buffer_.clear();
+        return true;
+    }
+
+    // Number of pages buffered before they are written out
+    static const size_t kBufferPages = 1 << 16;
+
+    // File being written
+    std::FILE* file_;
+    // Number of pages flushed to the file so far
+    uint64_t num_pages_;
+    // Pages that have not been written yet
+    std::vector<int> buffer_;
+    // Drops consecutive duplicates, including across appended chunks
+    RefStringCleaner cleaner_;
+    // Description of the last error
+    std::string error_;
+};
+
+/*!
+ * \brief The MappedTrace class memory maps a binary trace file read only and
+ * exposes its pages as a RefStringView. The operating system pages the trace
+ * in on demand, so traces larger than the physical memory can be replayed,
+ * and every algorithm constructed on View() shares the one mapping.
+ */
+class MappedTrace
+{
+public:
+    MappedTrace()
+        : mapping_(nullptr), mapping_size_(0)
+#ifdef _WIN32
+        , file_(INVALID_HANDLE_VALUE), file_mapping_(nullptr)
+#endif
+    {}
+
+    ~MappedTrace()
+    {
+        Close();
+    }
+
+    /*!
+     * \brief Open maps the trace file at path and checks its header
+     * \param path Path of the trace file
+     * \return True if the file is a valid trace and could be mapped
+     */
+    bool Open(const std::string& path)
+    {
+        Close();
+        error_.clear();
+
+        if (!Map(path))
+        {
+            Close();
+            return false;
+        }
+
+        // Make sure this is actually a trace file and that it is as long as
+        // the header says it is before handing out any pages
+        const TraceFileHeader* header = static_cast<const TraceFileHeader*>(mapping_);
+        if (mapping_size_ < sizeof(TraceFileHeader) ||
+            std::memcmp(header->magic, kTraceFileMagic, sizeof(header->magic)) != 0)
+        {
+            error_ = path + " is not a trace file";
+            Close();
+            return false;
+        }
+
+        if (header->page_width != sizeof(int32_t) ||
+            header->num_pages > (mapping_size_ - sizeof(TraceFileHeader)) / sizeof(int32_t))
+        {
+            error_ = path + " is truncated or has an unsupported page width";
+            Close();
+            return false;
+        }
+
+        const int* pages = reinterpret_cast<const int*>(
+                    static_cast<const char*>(mapping_) + sizeof(TraceFileHeader));
+        view_ = RefStringView(pages, (size_t) header->num_pages);
+        return true;
+    }
+
+    /*!
+     * \brief Close unmaps the trace. Every view handed out becomes invalid.
+     */
+    void Close()
+    {
+#ifdef _WIN32
+        if (mapping_ != nullptr)
+        {
+            UnmapViewOfFile(mapping_);
+        }
+        if (file_mapping_ != nullptr)
+        {
+            CloseHandle(file_mapping_);
+        }
+        if (file_ != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(file_);
+        }
+        file_mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (mapping_ != nullptr)
+        {
+            munmap(mapping_, mapping_size_);
+        }
+#endif
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+        view_ = RefStringView();
+    }
+
+    /*!
+     * \brief View returns the pages of the trace without copying them
+     */
+    RefStringView View() const { return view_; }
+
+    bool IsOpen() const { return mapping_ != nullptr; }
+
+    /*!
+     * \brief Error describes the last thing that went wrong
+     */
+    const std::string& Error() const { return error_; }
+
+private:
+    MappedTrace(const MappedTrace&) = delete;
+    MappedTrace& operator=(const MappedTrace&) = delete;
+
+    /*!
+     * \brief Map maps the whole file at path into memory read only
+     */
+    bool Map(const std::string& path)
+    {
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER size;
+        if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &size))
+        {
+            error_ = "Could not open " + path;
+            return false;
+        }
+
+        mapping_size_ = (size_t) size.QuadPart;
+        if (mapping_size_ == 0)
+        {
+            error_ = path + " is empty";
+            return false;
+        }
+
+        file_mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (file_mapping_ != nullptr)
+        {
+            mapping_ = MapViewOfFile(file_mapping_, FILE_MAP_READ, 0, 0, 0);
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0)
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+            error_ = "Could not open " + path;
+            return false;
+        }
+
+        mapping_size_ = (size_t) info.st_size;
+        if (mapping_size_ == 0)
+        {
+            ::close(fd);
+            error_ = path + " is empty";
+            return false;
+        }
+
+        // The mapping keeps its own reference to the file so the descriptor
+        // is not needed once the file is mapped
+        void* mapping = mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping != MAP_FAILED)
+        {
+            mapping_ = mapping;
+            // The algorithms read the trace front to back
+            madvise(mapping_, mapping_size_, MADV_SEQUENTIAL);
+        }
+#endif
+        if (mapping_ == nullptr)
+        {
+            mapping_size_ = 0;
+            error_ = "Could not map " + path;
+            return false;
+        }
+        return true;
+    }
+
+    // Start of the mapped file
+    void* mapping_;
+    // Size of the mapped file in bytes
+    size_t mapping_size_;
+    // Pages of the trace inside the mapping
+    RefStringView view_;
+    // Description of the last error
+    std::string error_;
+#ifdef _WIN32
+    // Handles that have to stay open while the file is mapped
+    HANDLE file_;
+    HANDLE file_mapping_;
+#endif
+};
+
+/*!
+ * \brief SeekTraceFile moves to an absolute offset of a file. Plain fseek
+ * takes a long, which is 32 bits on Windows and would cut every offset past
+ * 2 GiB.
+ */
+inline bool SeekTraceFile(std::FILE* file, uint64_t offset)
+{
+#ifdef _WIN32
+    return _fseeki64(file, (long long) offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t) offset, SEEK_SET) == 0;
+#endif
+}
+
+/*!
+ * \brief TraceFileSize finds the size of an open file, with the same 64 bit
+ * offsets as SeekTraceFile. The position of the file is left at its end.
+ */
+inline bool TraceFileSize(std::FILE* file, uint64_t& size)
+{
+#ifdef _WIN32
+    if (_fseeki64(file, 0, SEEK_END) != 0)
+    {
+        return false;
+    }
+    long long end = _ftelli64(file);
+#else
+    if (fseeko(file, 0, SEEK_END) != 0)
+    {
+        return false;
+    }
+    off_t end = ftello(file);
+#endif
+    size = (uint64_t) end;
+    return end >= 0;
+}
+
+/*
+ * Compressed trace file layout. Page ids are split into blocks of a fixed
+ * number of pages (the last block may be shorter) and every block is stored
+ * frame of reference style: its first page goes in the block index and every
+ * other page is stored as the difference to the page before it. The
+ * differences are zigzag encoded, so small negative steps stay small, and
+ * bit packed at the width of the largest one in the block. Consecutive page
+ * ids of real traces are close together, so a block of a trace that walks
+ * through memory a few pages at a time takes 4 bits per page instead of 32.
+ * A few far jumps make the whole block wide, so when that is larger a block
+ * stores its differences as little endian base 128 varints instead, which
+ * keeps small differences at a byte each; its width is then
+ * kVarintBlockWidth. Every block decodes on its own and the index at the
+ * end of the file says where each one is, so a block can be read without
+ * the others.
+ *
+ *   offset  size  field
+ *        0     8  magic "PRTRACEZ"
+ *        8     4  pages per block
+ *       12     4  flags (reserved, always 0)
+ *       16     8  number of page ids
+ *       24     8  number of blocks
+ *       32     8  offset of the block index
+ *       40     .  blocks, (pages - 1) * width bits each rounded up to bytes,
+ *                 or (pages - 1) varints
+ *        .  24*b  block index, for every block its offset (8), its size in
+ *                 bytes (4), its number of pages (4), its first page (4) and
+ *                 the bit width of its differences (4)
+ *
+ * Bits are packed starting at the lowest bit of the first byte, so the
+ * blocks read the same on any host. The header and the block index are
+ * written as they are in memory, in host byte order like a binary trace.
+ */
+
+/*!
+ * \brief The CompressedTraceHeader struct is the fixed size header at the
+ * start of every compressed trace file
+ */
+struct CompressedTraceHeader
+{
+    char magic[8];
+    uint32_t block_pages;
+    uint32_t flags;
+    uint64_t num_pages;
+    uint64_t num_blocks;
+    uint64_t index_offset;
+};
+
+/*!
+ * \brief The CompressedTraceBlock struct is one entry of the block index
+ */
+struct CompressedTraceBlock
+{
+    uint64_t offset;
+    uint32_t size;
+    uint32_t num_pages;
+    int32_t first_page;
+    uint32_t bit_width;
+};
+
+static const char kCompressedTraceMagic[8] = {'P', 'R', 'T', 'R', 'A', 'C', 'E', 'Z'};
+
+// Bit width of a block whose differences are varints rather than bit packed
+static const uint32_t kVarintBlockWidth = 0xffffffffu;
+
+/*!
+ * \brief The CompressedTraceWriter class writes a compressed trace file one
+ * chunk of pages at a time. Like TraceFileWriter it drops consecutive
+ * duplicate pages while writing, including across chunks and blocks.
+ */
+class CompressedTraceWriter
+{
+public:
+    CompressedTraceWriter() : file_(nullptr), block_pages_(kDefaultBlockPages), num_pages_(0), offset_(0) {}
+
+    ~CompressedTraceWriter()
+    {
+        Close();
+    }
+
+    /*!
+     * \brief Open creates (or truncates) the file at path and writes a
+     * placeholder header that is filled in by Close()
+     * \param path Path of the trace file
+     * \param block_pages Number of pages in every block
+     * \return True if the file could be created
+     */
+    bool Open(const std::string& path, uint32_t block_pages = kDefaultBlockPages)
+    {
+        Close();
+        error_.clear();
+
+        file_ = std::fopen(path.c_str(), "wb");
+        if (file_ == nullptr)
+        {
+            error_ = "Could not create " + path;
+            return false;
+        }
+
+        block_pages_ = block_pages == 0 ? (uint32_t) kDefaultBlockPages : block_pages;
+        num_pages_ = 0;
+        offset_ = sizeof(CompressedTraceHeader);
+        cleaner_.Reset();
+        block_.clear();
+        index_.clear();
+        return WriteHeader();
+    }
+
+    /*!
+     * \brief Append writes count pages to the end of the trace
+     * \param pages First page to write
+     * \param count Number of pages to write
+     * \return True if the pages could be written
+     */
+    bool Append(const int* pages, size_t count)
+    {
+        while (count > 0)
+        {
+            // Fill the current block and drop any repeated pages
+            size_t room = block_pages_ - block_.size();
+            size_t take = count < room ? count : room;
+            size_t start = block_.size();
+            block_.insert(block_.end(), pages, pages + take);
+            block_.resize(start + cleaner_.Filter(block_.data() + start, take));
+            pages += take;
+            count -= take;
+
+            if (block_.size() == block_pages_ && !FlushBlock())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Append(RefStringView pages)
+    {
+        return Append(pages.data(), pages.size());
+    }
+
+    /*!
+     * \brief Close writes the last block, the block index and the final
+     * header and closes the file
+     * \return True if everything was written
+     */
+    bool Close()
+    {
+        if (file_ == nullptr)
+        {
+            return true;
+        }
+
+        bool ok = FlushBlock();
+        if (ok && !index_.empty() &&
+            std::fwrite(index_.data(), sizeof(CompressedTraceBlock), index_.size(), file_) != index_.size())
+        {
+            error_ = "Could not write the block index";
+            ok = false;
+        }
+        ok = ok && SeekTraceFile(file_, 0) && WriteHeader();
+        ok = std::fclose(file_) == 0 && ok;
+        file_ = nullptr;
+
+        if (!ok && error_.empty())
+        {
+            error_ = "Could not write the trace file";
+        }
+        return ok;
+    }
+
+    /*!
+     * \brief Error describes the last thing that went wrong
+     */
+    const std::string& Error() const { return error_; }
+
+    /*!
+     * \brief WriteCompressedTraceFile writes a whole reference string to a
+     * compressed trace file
+     * \param path Path of the trace file
+     * \param ref_string Pages to write
+     * \return True if the file was written
+     */
+    static bool WriteCompressedTraceFile(const std::string& path, RefStringView ref_string)
+    {
+        CompressedTraceWriter writer;
+        return writer.Open(path) && writer.Append(ref_string) && writer.Close();
+    }
+
+    /*!
+     * \brief EncodeBlock appends the differences of a block of pages to
+     * bytes, bit packed or as varints, whichever is smaller
+     * \param pages Pages of the block, at least one
+     * \param count Number of pages
+     * \param bytes Receives the encoding
+     * \return The bit width the differences were packed at, or
+     * kVarintBlockWidth
+     */
+    static uint32_t EncodeBlock(const int* pages, size_t count, std::vector<uint8_t>& bytes)
+    {
+        // The widest difference sets the width of the whole block
+        uint64_t widest = 0;
+        uint64_t varint_size = 0;
+        for (size_t i = 1; i < count; ++i)
+        {
+            uint64_t zigzag = ZigZag((int64_t) pages[i] - pages[i - 1]);
+            widest |= zigzag;
+            do
+            {
+                varint_size += 1;
+                zigzag >>= 7;
+            }
+            while (zigzag != 0);
+        }
+        uint32_t width = 0;
+        while (width < 64 && (widest >> width) != 0)
+        {
+            ++width;
+        }
+
+        if (varint_size < ((uint64_t) (count - 1) * width + 7) / 8)
+        {
+            for (size_t i = 1; i < count; ++i)
+            {
+                uint64_t zigzag = ZigZag((int64_t) pages[i] - pages[i - 1]);
+                while (zigzag >= 0x80)
+                {
+                    bytes.push_back((uint8_t) (zigzag | 0x80));
+                    zigzag >>= 7;
+                }
+                bytes.push_back((uint8_t) zigzag);
+            }
+            return kVarintBlockWidth;
+        }
+
+        // At most 7 bits are pending before a difference of up to 33 bits
+        // is added, so the accumulator never overflows
+        uint64_t pending = 0;
+        uint32_t num_pending = 0;
+        for (size_t i = 1; i < count && width > 0; ++i)
+        {
+            pending |= ZigZag((int64_t) pages[i] - pages[i - 1]) << num_pending;
+            num_pending += width;
+            while (num_pending >= 8)
+            {
+                bytes.push_back((uint8_t) pending);
+                pending >>= 8;
+                num_pending -= 8;
+            }
+        }
+        if (num_pending > 0)
+        {
+            bytes.push_back((uint8_t) pending);
+        }
+        return width;
+    }
+
+    static uint64_t ZigZag(int64_t delta)
+    {
+        return ((uint64_t) delta << 1) ^ (uint64_t) (delta >> 63);
+    }
+
+    // Pages per block unless told otherwise. Small enough that a jump in
+    // the trace only widens the differences of a few thousand pages, large
+    // enough that the index stays well under 1% of the file.
+    enum { kDefaultBlockPages = 1 << 12 };
+
+private:
+    CompressedTraceWriter(const CompressedTraceWriter&) = delete;
+    CompressedTraceWriter& operator=(const CompressedTraceWriter&) = delete;
+
+    bool WriteHeader()
+    {
+        CompressedTraceHeader header;
+        std::memcpy(header.magic, kCompressedTraceMagic, sizeof(header.magic));
+        header.block_pages = block_pages_;
+        header.flags = 0;
+        header.num_pages = num_pages_;
+        header.num_blocks = index_.size();
+        header.index_offset = offset_;
+
+        if (std::fwrite(&header, sizeof(header), 1, file_) != 1)
+        {
+            error_ = "Could not write the trace header";
+            return false;
+        }
+        return true;
+    }
+
+    bool FlushBlock()
+    {
+        if (block_.empty())
+        {
+            return true;
+        }
+
+        bytes_.clear();
+        uint32_t width = EncodeBlock(block_.data(), block_.size(), bytes_);
+        if (!bytes_.empty() && std::fwrite(bytes_.data(), 1, bytes_.size(), file_) != bytes_.size())
+        {
+            error_ = "Could not write the trace pages";
+            return false;
+        }
+
+        CompressedTraceBlock entry;
+        entry.offset = offset_;
+        entry.size = (uint32_t) bytes_.size();
+        entry.num_pages = (uint32_t) block_.size();
+        entry.first_page = block_.front();
+        entry.bit_width = width;
+        index_.push_back(entry);
+
+        offset_ += bytes_.size();
+        num_pages_ += block_.size();
+        block_.clear();
+        return true;
+    }
+
+    // File being written
+    std::FILE* file_;
+    // Pages in every block but the last
+    uint32_t block_pages_;
+    // Number of pages written to the file so far
+    uint64_t num_pages_;
+    // Offset the next block is written at
+    uint64_t offset_;
+    // Pages of the block being filled
+    std::vector<int> block_;
+    // Encoding of the block being written
+    std::vector<uint8_t> bytes_;
+    // Every block written so far
+    std::vector<CompressedTraceBlock> index_;
+    // Drops consecutive duplicates, including across appended chunks
+    RefStringCleaner cleaner_;
+    // Description of the last error
+    std::string error_;
+};
+
+/*!
+ * \brief The CompressedTraceReader class reads a compressed trace file one
+ * block at a time. Only the header and the block index are read by Open(),
+ * so a block can be decoded without touching the rest of the file and a
+ * trace can be replayed through a page cache in the memory of one block.
+ */
+class CompressedTraceReader
+{
+public:
+    CompressedTraceReader() : file_(nullptr), num_pages_(0), block_pages_(0) {}
+
+    ~CompressedTraceReader()
+    {
+        Close();
+    }
+
+    /*!
+     * \brief Open opens the trace file at path and reads its block index
+     * \param path Path of the trace file
+     * \return True if the file is a valid compressed trace
+     */
+    bool Open(const std::string& path)
+    {
+        Close();
+        error_.clear();
+
+        file_ = std::fopen(path.c_str(), "rb");
+        if (file_ == nullptr)
+        {
+            error_ = "Could not open " + path;
+            return false;
+        }
+
+        CompressedTraceHeader header;
+        if (std::fread(&header, sizeof(header), 1, file_) != 1 ||
+            std::memcmp(header.magic, kCompressedTraceMagic, sizeof(header.magic)) != 0)
+        {
+            error_ = path + " is not a compressed trace file";
+            Close();
+            return false;
+        }
+
+        // The index must run from where the header says to the end of the
+        // file, so a broken block count is caught before anything is
+        // allocated for it. Every bound is checked without overflowing.
+        uint64_t file_size = 0;
+        bool ok = TraceFileSize(file_, file_size) &&
+                header.index_offset >= sizeof(CompressedTraceHeader) &&
+                header.index_offset <= file_size &&
+                header.num_blocks == (file_size - header.index_offset) / sizeof(CompressedTraceBlock) &&
+                (file_size - header.index_offset) % sizeof(CompressedTraceBlock) == 0 &&
+                SeekTraceFile(file_, header.index_offset);
+
+        // The blocks must fit before the index and add up to the pages
+        uint64_t total = 0;
+        if (ok)
+        {
+            index_.resize((size_t) header.num_blocks);
+            ok = index_.empty() ||
+                    std::fread(index_.data(), sizeof(CompressedTraceBlock), index_.size(), file_) == index_.size();
+        }
+        for (size_t b = 0; ok && b < index_.size(); ++b)
+        {
+            const CompressedTraceBlock& entry = index_[b];
+            bool packed_ok = entry.bit_width <= 33 &&
+                    entry.size == ((uint64_t) (entry.num_pages - 1) * entry.bit_width + 7) / 8;
+            bool varint_ok = entry.bit_width == kVarintBlockWidth &&
+                    entry.size >= entry.num_pages - 1 && entry.size <= (uint64_t) (entry.num_pages - 1) * 5;
+            ok = entry.num_pages > 0 && (packed_ok || varint_ok) &&
+                    entry.offset <= header.index_offset && entry.size <= header.index_offset - entry.offset;
+            total += entry.num_pages;
+        }
+        if (!ok || total != header.num_pages)
+        {
+            error_ = path + " is truncated or has a broken block index";
+            Close();
+            return false;
+        }
+
+        num_pages_ = header.num_pages;
+        block_pages_ = header.block_pages;
+        return true;
+    }
+
+    void Close()
+    {
+        if (file_ != nullptr)
+        {
+            std::fclose(file_);
+        }
+        file_ = nullptr;
+        index_.clear();
+        num_pages_ = 0;
+        block_pages_ = 0;
+    }
+
+    bool IsOpen() const { return file_ != nullptr; }
+    uint64_t NumPages() const { return num_pages_; }
+    size_t NumBlocks() const { return index_.size(); }
+    uint32_t BlockPages() const { return block_pages_; }
+    const CompressedTraceBlock& Block(size_t block) const { return index_[block]; }
+
+    /*!
+     * \brief ReadBlock decodes one block
+     * \param block Index of the block
+     * \param pages Receives the pages of the block
+     * \return True if the block could be read and decoded
+     */
+    bool ReadBlock(size_t block, std::vector<int>& pages)
+    {
+        const CompressedTraceBlock& entry = index_[block];
+
+        // The decoder loads 8 bytes at a time, so the end is padded
+        bytes_.assign(entry.size + 8, 0);
+        if (!SeekTraceFile(file_, entry.offset) ||
+            std::fread(bytes_.data(), 1, entry.size, file_) != entry.size)
+        {
+            error_ = "Could not read a block of the trace";
+            return false;
+        }
+
+        pages.resize(entry.num_pages);
+        if (!DecodeBlock(bytes_.data(), entry, pages.data()))
+        {
+            error_ = "A block of the trace is corrupt";
+            return false;
+        }
+        return true;
+    }
+
+    /*!
+     * \brief ReadAll decodes every block into one reference string
+     * \return True if every block could be read
+     */
+    bool ReadAll(std::vector<int>& ref_string)
+    {
+        ref_string.clear();
+        ref_string.reserve((size_t) num_pages_);
+
+        std::vector<int> pages;
+        for (size_t block = 0; block < index_.size(); ++block)
+        {
+            if (!ReadBlock(block, pages))
+            {
+                return false;
+            }
+            ref_string.insert(ref_string.end(), pages.begin(), pages.end());
+        }
+        return true;
+    }
+
+    /*!
+     * \brief Replay feeds the whole trace through a page cache one block at
+     * a time. Any class with AccessMany(RefStringView) will do.
+     * \param cache Cache to feed
+     * \param page_faults Receives the number of page faults
+     * \return True if every block could be read
+     */
+    template <class PageCache>
+    bool Replay(PageCache& cache, int& page_faults)
+    {
+        page_faults = 0;
+        std::vector<int> pages;
+        for (size_t block = 0; block < index_.size(); ++block)
+        {
+            if (!ReadBlock(block, pages))
+            {
+                return false;
+            }
+            page_faults += cache.AccessMany(RefStringView(pages));
+        }
+        return true;
+    }
+
+    /*!
+     * \brief Error describes the last thing that went wrong
+     */
+    const std::string& Error() const { return error_; }
+
+    /*!
+     * \brief DecodeBlock decodes the pages of a block whose index entry has
+     * been checked by Open()
+     * \param bytes Encoding of the block followed by 8 bytes of padding
+     * \param entry Index entry of the block
+     * \param pages Receives entry.num_pages pages
+     * \return False if the varints of the block do not fill it exactly. Bit
+     * packed blocks always decode.
+     */
+    static bool DecodeBlock(const uint8_t* bytes, const CompressedTraceBlock& entry, int* pages)
+    {
+        if (entry.bit_width == kVarintBlockWidth)
+        {
+            return DecodeVarintBlock(bytes, entry, pages);
+        }
+
+        const uint32_t width = entry.bit_width;
+        const uint64_t mask = width == 0 ? 0 : ~0ull >> (64 - width);
+
+        // A difference starts at most 7 bits into a byte and is at most 33
+        // bits wide, so a single 8 byte load always holds all of it
+        int64_t previous = entry.first_page;
+        pages[0] = entry.first_page;
+        uint64_t bit = 0;
+        for (uint32_t i = 1; i < entry.num_pages; ++i, bit += width)
+        {
+            uint64_t word = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ || defined(_M_X64) || defined(_M_IX86)
+            std::memcpy(&word, bytes + bit / 8, 8);
+#else
+            for (int b = 7; b >= 0; --b)
+            {
+                word = (word << 8) | bytes[bit / 8 + b];
+            }
+#endif
+            uint64_t zigzag = (word >> (bit % 8)) & mask;
+            previous += (int64_t) (zigzag >> 1) ^ -(int64_t) (zigzag & 1);
+            pages[i] = (int) previous;
+        }
+        return true;
+    }
+
+private:
+    CompressedTraceReader(const CompressedTraceReader&) = delete;
+    CompressedTraceReader& operator=(const CompressedTraceReader&) = delete;
+
+    static bool DecodeVarintBlock(const uint8_t* bytes, const CompressedTraceBlock& entry, int* pages)
+    {
+        const uint8_t* end = bytes + entry.size;
+        int64_t previous = entry.first_page;
+        pages[0] = entry.first_page;
+        for (uint32_t i = 1; i < entry.num_pages; ++i)
+        {
+            // Most differences fit in one byte
+            uint64_t zigzag = 0;
+            int shift = 0;
+            for (;;)
+            {
+                if (bytes == end || shift > 63)
+                {
+                    return false;
+                }
+                uint8_t byte = *bytes++;
+                zigzag |= (uint64_t) (byte & 0x7f) << shift;
+                shift += 7;
+                if (byte < 0x80)
+                {
+                    break;
+                }
+            }
+
+            previous += (int64_t) (zigzag >> 1) ^ -(int64_t) (zigzag & 1);
+            pages[i] = (int) previous;
+        }
+        return bytes == end;
+    }
+
+    // File being read
+    std::FILE* file_;
+    // Number of pages in the trace and in every block but the last
+    uint64_t num_pages_;
+    uint32_t block_pages_;
+    // Where every block is
+    std::vector<CompressedTraceBlock> index_;
+    // Encoding of the block being read
+    std::vector<uint8_t> bytes_;
+    // Description of the last error
+    std::string error_;
+};
+
+#endif // TRACEFILE_H
@@ -0,0 +1,470 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "PageReplacement.h"
+#include "RefStringGenerator.h"
+
+/*
+ * Benchmark suite for the page replacement algorithms. Every benchmark is
+ * run until it has taken at least --min-time seconds and reports how many
+ * references per second it handled and how much it allocated per run. The
+ * results are written as JSON with a fixed layout so they can be diffed and
+ * tracked from one commit to the next.
+ *
+ * Macro benchmarks run CalculatePageFaults of a whole algorithm over a
+ * generated reference string. Micro benchmarks time the building blocks on
+ * their own: the streaming caches, the cleaner and the generator.
+ */
+
+// Allocation counters, bumped by the replacement operator new below
+static std::atomic<unsigned long long> g_allocated_bytes(0);
+static std::atomic<unsigned long long> g_allocations(0);
+
+void* operator new(std::size_t size)
+{
+    g_allocated_bytes += size;
+    g_allocations += 1;
+
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+// Both deletes free through here. It is kept out of line because GCC warns
+// about free() on a pointer from operator new once the delete is inlined into
+// a caller, even though this operator new does allocate with malloc.
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noinline))
+#endif
+static void FreeAllocation(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    FreeAllocation(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    FreeAllocation(pointer);
+}
+
+/*!
+ * \brief The BenchmarkOptions struct holds everything parsed from argv
+ */
+struct BenchmarkOptions
+{
+    std::vector<size_t> sizes = {1000, 10000, 100000, 1000000};
+    std::vector<int> frame_counts = {1, 16, 256, 4096};
+    std::vector<RefStringGenerator::Workload> workloads = {
+        RefStringGenerator::Workload::Uniform, RefStringGenerator::Workload::Zipf,
+        RefStringGenerator::Workload::Loop, RefStringGenerator::Workload::Scan};
+    std::vector<PageReplacementAlgorithm> algorithms;
+    // Number of distinct pages as a multiple of the largest frame count
+    int page_factor = 4;
+    double min_time = 0.2;
+    // Simulations estimated to take more than this many steps are skipped
+    double max_work = 5e9;
+    uint64_t seed = 1;
+    bool micro = true;
+    bool macro = true;
+};
+
+/*!
+ * \brief The BenchmarkResult struct is one line of the JSON output
+ */
+struct BenchmarkResult
+{
+    std::string name;
+    std::string kind;
+    std::string algorithm;
+    std::string workload;
+    size_t references;
+    int frames;
+    long long iterations;
+    double seconds_per_iteration;
+    double bytes_per_iteration;
+    double allocations_per_iteration;
+    long long page_faults;
+};
+
+static void PrintUsage(std::FILE* out)
+{
+    std::fprintf(out,
+        "Usage: PageReplacementBench [options]\n"
+        "\n"
+        "Options:\n"
+        "  --sizes LIST        Reference string lengths (default: 1e3,1e4,1e5,1e6)\n"
+        "  --frames LIST       Frame counts (default: 1,16,256,4096)\n"
+        "  --workloads LIST    uniform, zipf, loop and/or scan (default: all)\n"
+        "  --algorithms LIST   Algorithm ids (default: all)\n"
+        "  --page-factor N     Distinct pages per frame of the largest frame count (default: 4)\n"
+        "  --min-time SECONDS  Minimum time to run every benchmark for (default: 0.2)\n"
+        "  --max-work N        Skip simulations estimated to take more steps (default: 5e9)\n"
+        "  --seed N            Seed of the generated reference strings (default: 1)\n"
+        "  --micro-only        Only run the micro benchmarks\n"
+        "  --macro-only        Only run the macro benchmarks\n"
+        "  -h, --help          Show this help\n");
+}
+
+/*!
+ * \brief SplitList splits a comma separated list
+ */
+static std::vector<std::string> SplitList(const std::string& text)
+{
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= text.size())
+    {
+        size_t comma = text.find(',', start);
+        if (comma == std::string::npos)
+        {
+            comma = text.size();
+        }
+        items.push_back(text.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return items;
+}
+
+/*!
+ * \brief ParseNumber parses a positive number, scientific notation like 1e6
+ * is allowed because sizes are easier to read that way
+ */
+static bool ParseNumber(const std::string& text, double& value)
+{
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0' && value >= 0;
+}
+
+static std::string ParseOptions(int argc, char* argv[], BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        std::string text = i + 1 < argc ? argv[i + 1] : "";
+        double number = 0;
+
+        if (arg == "-h" || arg == "--help")
+        {
+            PrintUsage(stdout);
+            std::exit(0);
+        }
+        else if (arg == "--micro-only")
+        {
+            options.macro = false;
+            continue;
+        }
+        else if (arg == "--macro-only")
+        {
+            options.micro = false;
+            continue;
+        }
+        else if (i + 1 >= argc)
+        {
+            return "Missing value for " + arg;
+        }
+
+        i += 1;
+        if (arg == "--sizes" || arg == "--frames")
+        {
+            std::vector<std::string> items = SplitList(text);
+            if (arg == "--sizes")
+            {
+                options.sizes.clear();
+            }
+            else
+            {
+                options.frame_counts.clear();
+            }
+
+            for (const std::string& item : items)
+            {
+                if (!ParseNumber(item, number))
+                {
+                    return "Invalid number '" + item + "'";
+                }
+                if (arg == "--sizes")
+                {
+                    options.sizes.push_back((size_t) number);
+                }
+                else
+                {
+                    if (number < 1 || number > 0x7fffffff)
+                    {
+                        return "Frame counts must be at least 1";
+                    }
+                    options.frame_counts.push_back((int) number);
+                }
+            }
+        }
+        else if (arg == "--workloads")
+        {
+            options.workloads.clear();
+            for (const std::string& item : SplitList(text))
+            {
+                RefStringGenerator::Workload workload;
+                if (!RefStringGenerator::FindWorkload(item, workload))
+                {
+                    return "Unknown workload '" + item + "'";
+                }
+                options.workloads.push_back(workload);
+            }
+        }
+        else if (arg == "--algorithms")
+        {
+            for (const std::string& item : SplitList(text))
+            {
+                PageReplacementAlgorithm algorithm;
+                if (!FindPageReplacementAlgorithm(item, algorithm))
+                {
+                    return "Unknown algorithm '" + item + "'";
+                }
+                options.algorithms.push_back(algorithm);
+            }
+        }
+        else if (arg == "--page-factor" && ParseNumber(text, number) && number >= 1)
+        {
+            options.page_factor = (int) number;
+        }
+        else if (arg == "--min-time" && ParseNumber(text, number))
+        {
+            options.min_time = number;
+        }
+        else if (arg == "--max-work" && ParseNumber(text, number))
+        {
+            options.max_work = number;
+        }
+        else if (arg == "--seed" && ParseNumber(text, number))
+        {
+            options.seed = (uint64_t) number;
+        }
+        else
+        {
+            return "Invalid option " + arg + " " + text;
+        }
+    }
+
+    if (options.algorithms.empty())
+    {
+        for (const PageReplacementAlgorithmInfo& info : PageReplacementAlgorithms())
+        {
+            options.algorithms.push_back(info.algorithm);
+        }
+    }
+
+    return std::string();
+}
+
+/*!
+ * \brief EstimatedWork guesses how many steps an algorithm takes so the
+ * quadratic reference implementations can be skipped on large inputs
+ */
+static double EstimatedWork(PageReplacementAlgorithm algorithm, size_t references, int frames)
+{
+    double n = (double) references;
+    switch (algorithm)
+    {
+        case PageReplacementAlgorithm::FIFO:
+        case PageReplacementAlgorithm::LRU:
+            return n * frames;
+        case PageReplacementAlgorithm::OPT:
+            return n * n * frames;
+        default:
+            return n;
+    }
+}
+
+/*!
+ * \brief RunBenchmark calls body until at least min_time seconds have passed
+ * and fills in the timing and allocation fields of result. body returns the
+ * page faults it found, which also keeps the compiler from dropping the work.
+ */
+template <class Body>
+static void RunBenchmark(BenchmarkResult& result, double min_time, Body body)
+{
+    // One untimed run warms up the caches and the allocator
+    result.page_faults = body();
+
+    long long iterations = 1;
+    for (;;)
+    {
+        unsigned long long bytes_before = g_allocated_bytes;
+        unsigned long long allocations_before = g_allocations;
+        auto start = std::chrono::steady_clock::now();
+
+        for (long long i = 0; i < iterations; ++i)
+        {
+            result.page_faults = body();
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        result.iterations = iterations;
+        result.seconds_per_iteration = elapsed.count() / iterations;
+        result.bytes_per_iteration = (double) (g_allocated_bytes - bytes_before) / iterations;
+        result.allocations_per_iteration = (double) (g_allocations - allocations_before) / iterations;
+
+        // Grow the iteration count towards min_time, like Google Benchmark does
+        if (elapsed.count() >= min_time || iterations >= (1LL << 40))
+        {
+            return;
+        }
+        double scale = elapsed.count() > 0 ? 1.4 * min_time / elapsed.count() : 10.0;
+        iterations = (long long) (iterations * (scale > 10.0 ? 10.0 : (scale < 2.0 ? 2.0 : scale)));
+    }
+}
+
+static void PrintResult(const BenchmarkResult& result, bool first)
+{
+    double references_per_second = result.seconds_per_iteration > 0
+            ? result.references / result.seconds_per_iteration : 0;
+
+    std::printf("%s    {\"name\": \"%s\", \"kind\": \"%s\", \"algorithm\": \"%s\", \"workload\": \"%s\", "
+                "\"references\": %llu, \"frames\": %d, \"iterations\": %lld, "
+                "\"seconds_per_iteration\": %.9g, \"references_per_second\": %.6g, "
+                "\"bytes_allocated_per_iteration\": %.6g, \"allocations_per_iteration\": %.6g, "
+                "\"page_faults\": %lld}",
+                first ? "" : ",\n", result.name.c_str(), result.kind.c_str(), result.algorithm.c_str(),
+                result.workload.c_str(), (unsigned long long) result.references, result.frames,
+                result.iterations, result.seconds_per_iteration, references_per_second,
+                result.bytes_per_iteration, result.allocations_per_iteration, result.page_faults);
+    std::fflush(stdout);
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    std::string error = ParseOptions(argc, argv, options);
+    if (!error.empty())
+    {
+        std::fprintf(stderr, "%s\n\n", error.c_str());
+        PrintUsage(stderr);
+        return 2;
+    }
+
+    int largest_frames = 1;
+    for (int frames : options.frame_counts)
+    {
+        largest_frames = frames > largest_frames ? frames : largest_frames;
+    }
+    const int num_pages = largest_frames * options.page_factor;
+
+    std::printf("{\n  \"context\": {\"pages\": %d, \"seed\": %llu, \"min_time\": %g},\n",
+                num_pages, (unsigned long long) options.seed, options.min_time);
+    std::printf("  \"benchmarks\": [\n");
+    bool first = true;
+
+    for (size_t size : options.sizes)
+    {
+        for (RefStringGenerator::Workload workload : options.workloads)
+        {
+            // The reference string is generated and cleaned outside the timed
+            // region and shared by every benchmark through a view
+            std::vector<int> ref_string = RefStringGenerator::GenerateWorkload(
+                        workload, size, num_pages, options.seed);
+            RefStringView view(ref_string);
+            const char* workload_name = RefStringGenerator::WorkloadName(workload);
+
+            for (int frames : options.frame_counts)
+            {
+                std::string suffix = std::string("/") + workload_name + "/n:" + std::to_string(size) +
+                        "/frames:" + std::to_string(frames);
+
+                for (PageReplacementAlgorithm algorithm : options.algorithms)
+                {
+                    if (!options.macro || EstimatedWork(algorithm, size, frames) > options.max_work)
+                    {
+                        continue;
+                    }
+
+                    BenchmarkResult result;
+                    result.kind = "macro";
+                    result.algorithm = PageReplacementAlgorithmInfoOf(algorithm).id;
+                    result.name = result.algorithm + suffix;
+                    result.workload = workload_name;
+                    result.references = size;
+                    result.frames = frames;
+
+                    RunBenchmark(result, options.min_time, [&]() {
+                        return (long long) CreatePageReplacement(algorithm, view, num_pages, frames)
+                                ->CalculatePageFaults();
+                    });
+                    PrintResult(result, first);
+                    first = false;
+                }
+
+                if (!options.micro)
+                {
+                    continue;
+                }
+
+                // The streaming caches on their own, one Access per reference
+                BenchmarkResult fifo_cache = {"cache-fifo" + suffix, "micro", "cache-fifo", workload_name,
+                                              size, frames, 0, 0, 0, 0, 0};
+                RunBenchmark(fifo_cache, options.min_time, [&]() {
+                    FIFOPageCache cache(frames);
+                    return (long long) cache.AccessMany(view);
+                });
+                PrintResult(fifo_cache, first);
+                first = false;
+
+                BenchmarkResult lru_cache = {"cache-lru" + suffix, "micro", "cache-lru", workload_name,
+                                             size, frames, 0, 0, 0, 0, 0};
+                RunBenchmark(lru_cache, options.min_time, [&]() {
+                    LRUPageCache cache(frames);
+                    return (long long) cache.AccessMany(view);
+                });
+                PrintResult(lru_cache, first);
+            }
+
+            if (!options.micro)
+            {
+                continue;
+            }
+
+            // Cleaning a string full of repeats, the copy is part of the cost
+            BenchmarkResult clean = {std::string("clean/") + workload_name + "/n:" + std::to_string(size),
+                                     "micro", "clean", workload_name, size, 0, 0, 0, 0, 0, 0};
+            std::vector<int> doubled(size);
+            for (size_t i = 0; i < size; ++i)
+            {
+                doubled[i] = ref_string[i / 2];
+            }
+            std::vector<int> scratch;
+            RunBenchmark(clean, options.min_time, [&]() {
+                scratch = doubled;
+                AbstractPageReplacement::CleanRefString(scratch);
+                return (long long) scratch.size();
+            });
+            PrintResult(clean, first);
+            first = false;
+        }
+
+        if (options.micro)
+        {
+            BenchmarkResult generate = {"generate/uniform/n:" + std::to_string(size), "micro", "generate",
+                                        "uniform", size, 0, 0, 0, 0, 0, 0};
+            std::vector<int> buffer(size);
+            RunBenchmark(generate, options.min_time, [&]() {
+                RefStringGenerator::Fill(buffer.data(), size, num_pages, options.seed);
+                return size ? (long long) buffer[size - 1] : 0LL;
+            });
+            PrintResult(generate, first);
+            first = false;
+        }
+    }
+
+    std::printf("\n  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,553 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "AddressTrace.h"
+#include "LocalityProfiler.h"
+#include "PageReplacement.h"
+#include "PageFaultSweep.h"
+#include "RefStringParser.h"
+#include "TraceFile.h"
+
+/*
+ * Headless front end for the page replacement algorithms. Reads a reference
+ * string from a text file, a binary trace file, an address trace or stdin, runs the requested
+ * algorithms over a range of frame counts and prints the page faults as CSV
+ * or JSON so experiments can be scripted on machines without a display.
+ */
+
+/*!
+ * \brief The CommandLineOptions struct holds everything parsed from argv
+ */
+struct CommandLineOptions
+{
+    std::string trace_path;
+    std::vector<PageReplacementAlgorithm> algorithms;
+    int min_frames = 1;
+    int max_frames = 8;
+    int num_pages = -1;
+    unsigned num_threads = 0;
+    bool json = false;
+    std::string convert_path;
+    std::string compress_path;
+    // Read the trace as byte addresses instead of page numbers
+    bool addresses = false;
+    AddressTraceOptions address_options;
+    // Estimate the LRU curve from a sample instead of simulating
+    double shards_rate = 0.0;
+    int shards_samples = 0;
+    // Profile the locality of the trace instead of simulating
+    bool profile = false;
+    int profile_window = 0;
+};
+
+static void PrintUsage(std::FILE* out)
+{
+    std::fprintf(out,
+        "Usage: PageReplacementCLI [options] [trace]\n"
+        "\n"
+        "Reads a reference string and prints the page faults of every algorithm\n"
+        "at every frame count. The trace is either text (page numbers separated\n"
+        "by commas or whitespace), a binary trace file or a compressed trace\n"
+        "file. Without a trace, or with -, the text is read from stdin.\n"
+        "\n"
+        "Options:\n"
+        "  -a, --algorithms LIST  Comma separated algorithms (default: all\n"
+        "                         but the quadratic opt; opt-heap faults the same)\n"
+        "  -f, --frames N|MIN-MAX Frame counts to simulate (default: 1-8)\n"
+        "  -p, --pages N          Number of pages (default: largest page + 1)\n"
+        "  -j, --threads N        Worker threads (default: all hardware threads)\n"
+        "      --format csv|json  Output format (default: csv)\n"
+        "      --convert FILE     Write the trace as a binary trace file and exit\n"
+        "      --compress FILE    Write the trace as a compressed trace file and exit\n"
+        "      --addresses        The trace is a valgrind lackey or hex address trace\n"
+        "      --page-size SIZE   Page size of an address trace: 4K, 2M, 1G or bytes\n"
+        "                         (default: 4K)\n"
+        "      --references KIND  References of an address trace to simulate:\n"
+        "                         all, instructions or data (default: all)\n"
+        "      --shards RATE      Estimate the LRU faults up to the largest frame\n"
+        "                         count from a sample of RATE of the pages\n"
+        "      --shards-samples N Track at most N sampled pages, lowering the rate\n"
+        "      --profile          Print the reuse distance and reuse time histograms\n"
+        "                         and working set sizes of the trace\n"
+        "      --profile-window N Also print the working set size every N requests\n"
+        "  -h, --help             Show this help\n"
+        "\n"
+        "Algorithms:");
+
+    for (const PageReplacementAlgorithmInfo& info : PageReplacementAlgorithms())
+    {
+        std::fprintf(out, " %s", info.id);
+    }
+    std::fprintf(out, "\n");
+}
+
+/*!
+ * \brief ParseInt parses a whole string as a non negative int
+ * \return True if the string was a valid number
+ */
+static bool ParseInt(const std::string& text, int& value)
+{
+    if (text.empty())
+    {
+        return false;
+    }
+
+    char* end = nullptr;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || parsed < 0 || parsed > 0x7fffffffL)
+    {
+        return false;
+    }
+
+    value = (int) parsed;
+    return true;
+}
+
+/*!
+ * \brief ParseOptions fills options from argv
+ * \return An empty string on success, otherwise what was wrong
+ */
+static std::string ParseOptions(int argc, char* argv[], CommandLineOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+
+        // Fetches the value of an option that takes one
+        auto value = [&](std::string& out) {
+            if (i + 1 >= argc)
+            {
+                return false;
+            }
+            out = argv[++i];
+            return true;
+        };
+        std::string text;
+
+        if (arg == "-h" || arg == "--help")
+        {
+            PrintUsage(stdout);
+            std::exit(0);
+        }
+        else if (arg == "-a" || arg == "--algorithms")
+        {
+            if (!value(text))
+            {
+                return "Missing value for " + arg;
+            }
+
+            // Split the list on commas and look up every id
+            size_t start = 0;
+            while (start <= text.size())
+            {
+                size_t comma = text.find(',', start);
+                if (comma == std::string::npos)
+                {
+                    comma = text.size();
+                }
+
+                std::string id = text.substr(start, comma - start);
+                PageReplacementAlgorithm algorithm;
+                if (!FindPageReplacementAlgorithm(id, algorithm))
+                {
+                    return "Unknown algorithm '" + id + "'";
+                }
+                options.algorithms.push_back(algorithm);
+                start = comma + 1;
+            }
+        }
+        else if (arg == "-f" || arg == "--frames")
+        {
+            if (!value(text))
+            {
+                return "Missing value for " + arg;
+            }
+
+            size_t dash = text.find('-');
+            bool ok = dash == std::string::npos
+                    ? ParseInt(text, options.min_frames) && ParseInt(text, options.max_frames)
+                    : ParseInt(text.substr(0, dash), options.min_frames) &&
+                      ParseInt(text.substr(dash + 1), options.max_frames);
+            if (!ok || options.min_frames > options.max_frames)
+            {
+                return "Invalid frame range '" + text + "'";
+            }
+            if (options.min_frames < 1)
+            {
+                return "Frame counts must be at least 1";
+            }
+        }
+        else if (arg == "-p" || arg == "--pages")
+        {
+            if (!value(text) || !ParseInt(text, options.num_pages))
+            {
+                return "Invalid number of pages";
+            }
+        }
+        else if (arg == "-j" || arg == "--threads")
+        {
+            int threads = 0;
+            if (!value(text) || !ParseInt(text, threads))
+            {
+                return "Invalid number of threads";
+            }
+            options.num_threads = (unsigned) threads;
+        }
+        else if (arg == "--format")
+        {
+            if (!value(text) || (text != "csv" && text != "json"))
+            {
+                return "The format must be csv or json";
+            }
+            options.json = text == "json";
+        }
+        else if (arg == "--convert")
+        {
+            if (!value(options.convert_path))
+            {
+                return "Missing value for " + arg;
+            }
+        }
+        else if (arg == "--compress")
+        {
+            if (!value(options.compress_path))
+            {
+                return "Missing value for " + arg;
+            }
+        }
+        else if (arg == "--addresses")
+        {
+            options.addresses = true;
+        }
+        else if (arg == "--page-size")
+        {
+            if (!value(text) || !options.address_options.ParsePageSize(text))
+            {
+                return "The page size must be a power of two such as 4K, 2M or 1G";
+            }
+            options.addresses = true;
+        }
+        else if (arg == "--references")
+        {
+            if (!value(text) || (text != "all" && text != "instructions" && text != "data"))
+            {
+                return "The references must be all, instructions or data";
+            }
+            options.address_options.instructions = text != "data";
+            options.address_options.data = text != "instructions";
+            options.addresses = true;
+        }
+        else if (arg == "--shards")
+        {
+            if (!value(text))
+            {
+                return "Missing value for " + arg;
+            }
+
+            char* end = nullptr;
+            options.shards_rate = std::strtod(text.c_str(), &end);
+            if (*end != '\0' || !(options.shards_rate > 0.0 && options.shards_rate <= 1.0))
+            {
+                return "The sampling rate must be in (0, 1]";
+            }
+        }
+        else if (arg == "--shards-samples")
+        {
+            if (!value(text) || !ParseInt(text, options.shards_samples))
+            {
+                return "Invalid number of samples";
+            }
+        }
+        else if (arg == "--profile")
+        {
+            options.profile = true;
+        }
+        else if (arg == "--profile-window")
+        {
+            if (!value(text) || !ParseInt(text, options.profile_window))
+            {
+                return "Invalid profile window";
+            }
+            options.profile = true;
+        }
+        else if (arg.size() > 1 && arg[0] == '-')
+        {
+            return "Unknown option " + arg;
+        }
+        else if (options.trace_path.empty())
+        {
+            options.trace_path = arg;
+        }
+        else
+        {
+            return "Only one trace can be given";
+        }
+    }
+
+    // Default to every algorithm but the quadratic OPT, which would take
+    // hours on a large trace and faults the same as the heap OPT
+    if (options.algorithms.empty())
+    {
+        for (const PageReplacementAlgorithmInfo& info : PageReplacementAlgorithms())
+        {
+            if (info.algorithm != PageReplacementAlgorithm::OPT)
+            {
+                options.algorithms.push_back(info.algorithm);
+            }
+        }
+    }
+
+    return std::string();
+}
+
+/*!
+ * \brief IsTraceFile checks whether a file starts with the given trace magic
+ */
+static bool IsTraceFile(const std::string& path, const char (&trace_magic)[8])
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    char magic[sizeof(trace_magic)];
+    bool is_trace = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+            std::memcmp(magic, trace_magic, sizeof(magic)) == 0;
+    std::fclose(file);
+    return is_trace;
+}
+
+static void PrintCsv(const PageFaultSweepResult& result, size_t num_references)
+{
+    std::printf("algorithm,frames,references,page_faults,seconds\n");
+    for (size_t a = 0; a < result.algorithms.size(); ++a)
+    {
+        const char* id = PageReplacementAlgorithmInfoOf(result.algorithms[a]).id;
+        for (size_t f = 0; f < result.frame_counts.size(); ++f)
+        {
+            std::printf("%s,%d,%llu,%d,%.9f\n", id, result.frame_counts[f], (unsigned long long) num_references,
+                        result.page_faults[a][f], result.seconds[a][f]);
+        }
+    }
+}
+
+static void PrintJson(const PageFaultSweepResult& result, size_t num_references,
+                      int num_pages, double load_seconds, double total_seconds)
+{
+    std::printf("{\n  \"references\": %llu,\n  \"pages\": %d,\n", (unsigned long long) num_references, num_pages);
+    std::printf("  \"load_seconds\": %.9f,\n  \"total_seconds\": %.9f,\n", load_seconds, total_seconds);
+    std::printf("  \"results\": [");
+
+    const char* separator = "\n";
+    for (size_t a = 0; a < result.algorithms.size(); ++a)
+    {
+        const char* id = PageReplacementAlgorithmInfoOf(result.algorithms[a]).id;
+        for (size_t f = 0; f < result.frame_counts.size(); ++f)
+        {
+            std::printf("%s    {\"algorithm\": \"%s\", \"frames\": %d, \"page_faults\": %d, \"seconds\": %.9f}",
+                        separator, id, result.frame_counts[f], result.page_faults[a][f], result.seconds[a][f]);
+            separator = ",\n";
+        }
+    }
+
+    std::printf("\n  ]\n}\n");
+}
+
+static void PrintCurve(const MissRatioCurve& curve, const CommandLineOptions& options, double total_seconds)
+{
+    if (!options.json)
+    {
+        std::printf("frames,references,page_faults,error_bound\n");
+        for (int f = options.min_frames; f <= options.max_frames; ++f)
+        {
+            std::printf("%d,%llu,%.1f,%.1f\n", f, (unsigned long long) curve.num_references,
+                        curve.page_faults[f], curve.error_bounds[f]);
+        }
+        return;
+    }
+
+    std::printf("{\n  \"references\": %llu,\n  \"sampled\": %llu,\n  \"sampling_rate\": %.9f,\n",
+                (unsigned long long) curve.num_references, (unsigned long long) curve.num_sampled,
+                curve.sampling_rate);
+    std::printf("  \"total_seconds\": %.9f,\n  \"curve\": [", total_seconds);
+
+    const char* separator = "\n";
+    for (int f = options.min_frames; f <= options.max_frames; ++f)
+    {
+        std::printf("%s    {\"frames\": %d, \"page_faults\": %.1f, \"error_bound\": %.1f}",
+                    separator, f, curve.page_faults[f], curve.error_bounds[f]);
+        separator = ",\n";
+    }
+
+    std::printf("\n  ]\n}\n");
+}
+
+int main(int argc, char* argv[])
+{
+    CommandLineOptions options;
+    std::string error = ParseOptions(argc, argv, options);
+    if (!error.empty())
+    {
+        std::fprintf(stderr, "%s\n\n", error.c_str());
+        PrintUsage(stderr);
+        return 2;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Binary traces are mapped and read in place, compressed traces are
+    // decoded and text and address traces are parsed into a vector and cleaned
+    MappedTrace mapped_trace;
+    std::vector<int> text_ref_string;
+    RefStringView ref_string;
+
+    bool from_stdin = options.trace_path.empty() || options.trace_path == "-";
+    if (!from_stdin && IsTraceFile(options.trace_path, kTraceFileMagic))
+    {
+        if (!mapped_trace.Open(options.trace_path))
+        {
+            std::fprintf(stderr, "%s\n", mapped_trace.Error().c_str());
+            return 1;
+        }
+        ref_string = mapped_trace.View();
+    }
+    else if (!from_stdin && IsTraceFile(options.trace_path, kCompressedTraceMagic))
+    {
+        CompressedTraceReader reader;
+        if (!reader.Open(options.trace_path) || !reader.ReadAll(text_ref_string))
+        {
+            std::fprintf(stderr, "%s\n", reader.Error().c_str());
+            return 1;
+        }
+        ref_string = RefStringView(text_ref_string);
+    }
+    else
+    {
+        std::FILE* file = from_stdin ? stdin : std::fopen(options.trace_path.c_str(), "rb");
+        if (file == nullptr)
+        {
+            std::fprintf(stderr, "Could not open %s\n", options.trace_path.c_str());
+            return 1;
+        }
+
+        bool read = true;
+        if (options.addresses)
+        {
+            AddressTraceParser parser(options.address_options);
+            read = ReadAddressTrace(file, parser, text_ref_string);
+            if (parser.NumMalformedLines() > 0)
+            {
+                std::fprintf(stderr, "Skipped %llu malformed line(s), the first is line %llu\n",
+                             (unsigned long long) parser.NumMalformedLines(),
+                             (unsigned long long) parser.FirstMalformedLine());
+            }
+        }
+        else
+        {
+            RefStringParser parser;
+            read = ReadRefStringFile(file, parser, text_ref_string, options.num_threads);
+            if (parser.NumMalformed() > 0)
+            {
+                std::fprintf(stderr, "Skipped %s\n", parser.Error().c_str());
+            }
+        }
+        if (file != stdin)
+        {
+            std::fclose(file);
+        }
+        if (!read)
+        {
+            std::fprintf(stderr, "Could not read %s\n", options.trace_path.c_str());
+            return 1;
+        }
+
+        AbstractPageReplacement::CleanRefString(text_ref_string);
+        ref_string = RefStringView(text_ref_string);
+    }
+
+    if (!options.convert_path.empty())
+    {
+        TraceFileWriter writer;
+        if (!writer.Open(options.convert_path) || !writer.Append(ref_string) || !writer.Close())
+        {
+            std::fprintf(stderr, "%s\n", writer.Error().c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!options.compress_path.empty())
+    {
+        CompressedTraceWriter writer;
+        if (!writer.Open(options.compress_path) || !writer.Append(ref_string) || !writer.Close())
+        {
+            std::fprintf(stderr, "%s\n", writer.Error().c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    // The number of pages defaults to the smallest system the trace fits in
+    if (options.num_pages < 0)
+    {
+        int largest = -1;
+        for (auto i = ref_string.begin(); i != ref_string.end(); ++i)
+        {
+            largest = *i > largest ? *i : largest;
+        }
+        // Page INT_MAX would need one more page than an int can count
+        options.num_pages = (int) std::min<int64_t>((int64_t) largest + 1, INT_MAX);
+    }
+
+    std::chrono::duration<double> load_seconds = std::chrono::steady_clock::now() - start;
+
+    if (options.profile)
+    {
+        LocalityProfile profile = ProfileLocality(ref_string, options.profile_window);
+        if (options.json)
+        {
+            WriteLocalityProfileJson(profile, stdout);
+        }
+        else
+        {
+            WriteLocalityProfileCsv(profile, stdout);
+        }
+        return 0;
+    }
+
+    if (options.shards_rate > 0.0 || options.shards_samples > 0)
+    {
+        SHARDSPageReplacement shards(ref_string, options.num_pages, options.max_frames,
+                                     options.shards_rate > 0.0 ? options.shards_rate : 1.0,
+                                     options.shards_samples);
+        MissRatioCurve curve = shards.CalculateFaultCurve(options.max_frames);
+        std::chrono::duration<double> total_seconds = std::chrono::steady_clock::now() - start;
+        PrintCurve(curve, options, total_seconds.count());
+        return 0;
+    }
+
+    PageFaultSweepResult result = SweepPageFaults(ref_string, options.algorithms, options.num_pages,
+                                                  options.min_frames, options.max_frames,
+                                                  options.num_threads);
+
+    std::chrono::duration<double> total_seconds = std::chrono::steady_clock::now() - start;
+
+    if (options.json)
+    {
+        PrintJson(result, ref_string.size(), options.num_pages, load_seconds.count(), total_seconds.count());
+    }
+    else
+    {
+        PrintCsv(result, ref_string.size());
+    }
+
+    return 0;
+}
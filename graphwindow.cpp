@@ -27,12 +27,14 @@
 **
 ****************************************************************************/
 
-#include "graphwindow.h".h"
+#include "graphwindow.h"
 #include <QtGui/QResizeEvent>
 #include <QtWidgets/QGraphicsScene>
 #include <QtCharts/QChart>
 #include <QtCharts/QLineSeries>
 #include <QtCharts/QSplineSeries>
+#include <QtCharts/QValueAxis>
+#include <QtCharts/QLogValueAxis>
 #include <QtWidgets/QGraphicsTextItem>
 #include <QtGui/QMouseEvent>
 
@@ -40,8 +42,7 @@ View::View(QWidget *parent)
     : QGraphicsView(new QGraphicsScene, parent),
       m_coordX(0),
       m_coordY(0),
-      m_chart(0),
-      m_tooltip(0)
+      m_chart(0)
 {
     setDragMode(QGraphicsView::NoDrag);
     setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
@@ -50,25 +51,7 @@ View::View(QWidget *parent)
     // chart
     m_chart = new QChart;
     m_chart->setMinimumSize(640, 480);
-    m_chart->setTitle("Hover the line to show callout. Click the line to make it stay");
     m_chart->legend()->hide();
-    QLineSeries *series = new QLineSeries;
-    series->append(1, 3);
-    series->append(4, 5);
-    series->append(5, 4.5);
-    series->append(7, 1);
-    series->append(11, 2);
-    m_chart->addSeries(series);
-
-    QSplineSeries *series2 = new QSplineSeries;
-    series2->append(1.6, 1.4);
-    series2->append(2.4, 3.5);
-    series2->append(3.7, 2.5);
-    series2->append(7, 4);
-    series2->append(10, 2);
-    m_chart->addSeries(series2);
-
-    m_chart->createDefaultAxes();
     m_chart->setAcceptHoverEvents(true);
 
     setRenderHint(QPainter::Antialiasing);
@@ -102,3 +85,81 @@ void View::mouseMoveEvent(QMouseEvent *event)
     m_coordY->setText(QString("Y: %1").arg(m_chart->mapToValue(event->pos()).y()));
     QGraphicsView::mouseMoveEvent(event);
 }
+
+void View::ShowLocalityProfile(const LocalityProfile &profile, LocalityChart chart)
+{
+    m_chart->removeAllSeries();
+    for (QAbstractAxis *axis : m_chart->axes()) {
+        m_chart->removeAxis(axis);
+        delete axis;
+    }
+
+    QLineSeries *series = new QLineSeries;
+    QString title;
+    QString x_title;
+    QString y_title;
+    bool log_x = true;
+
+    // Histograms are drawn as the share of the requests at the lower bound
+    // of every bucket, cold requests are left out
+    auto add_histogram = [&](const LogHistogram &histogram) {
+        double total = profile.num_references > 0 ? (double) profile.num_references : 1.0;
+        for (int k = 0; k < (int) histogram.counts.size(); ++k) {
+            series->append((double) LogHistogram::LowerBound(k), histogram.counts[k] / total);
+        }
+    };
+
+    switch (chart) {
+    case LocalityChart::ReuseDistance:
+        add_histogram(profile.reuse_distances);
+        title = "Reuse distance";
+        x_title = "Distinct pages between requests";
+        y_title = "Share of requests";
+        break;
+    case LocalityChart::ReuseTime:
+        add_histogram(profile.reuse_times);
+        title = "Reuse time";
+        x_title = "Requests between requests";
+        y_title = "Share of requests";
+        break;
+    case LocalityChart::WorkingSetSize:
+        for (int k = 0; k < (int) profile.working_set_sizes.size(); ++k) {
+            series->append((double) LogHistogram::LowerBound(k), profile.working_set_sizes[k]);
+        }
+        title = "Average working set size";
+        x_title = "Window";
+        y_title = "Pages";
+        break;
+    case LocalityChart::WorkingSetTimeline:
+        for (int i = 0; i < (int) profile.working_set_timeline.size(); ++i) {
+            series->append((double) (i + 1) * profile.timeline_window, profile.working_set_timeline[i]);
+        }
+        title = QString("Working set size, window %1").arg(profile.timeline_window);
+        x_title = "Request";
+        y_title = "Pages";
+        log_x = false;
+        break;
+    }
+
+    m_chart->setTitle(title);
+    m_chart->addSeries(series);
+
+    QAbstractAxis *x_axis;
+    if (log_x) {
+        QLogValueAxis *axis = new QLogValueAxis;
+        axis->setBase(2.0);
+        axis->setLabelFormat("%g");
+        x_axis = axis;
+    } else {
+        x_axis = new QValueAxis;
+    }
+    x_axis->setTitleText(x_title);
+
+    QValueAxis *y_axis = new QValueAxis;
+    y_axis->setTitleText(y_title);
+
+    m_chart->addAxis(x_axis, Qt::AlignBottom);
+    m_chart->addAxis(y_axis, Qt::AlignLeft);
+    series->attachAxis(x_axis);
+    series->attachAxis(y_axis);
+}
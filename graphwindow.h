@@ -32,6 +32,8 @@
 #include <QtWidgets/QGraphicsView>
 #include <QtCharts/QChartGlobal>
 
+#include "LocalityProfiler.h"
+
 QT_BEGIN_NAMESPACE
 class QGraphicsScene;
 class QMouseEvent;
@@ -42,10 +44,19 @@ QT_CHARTS_BEGIN_NAMESPACE
 class QChart;
 QT_CHARTS_END_NAMESPACE
 
-class Callout;
-
 QT_CHARTS_USE_NAMESPACE
 
+/*!
+ * \brief The LocalityChart enum selects what View::ShowLocalityProfile plots
+ */
+enum class LocalityChart
+{
+    ReuseDistance,
+    ReuseTime,
+    WorkingSetSize,
+    WorkingSetTimeline
+};
+
 class View: public QGraphicsView
 {
     Q_OBJECT
@@ -53,20 +64,21 @@ class View: public QGraphicsView
 public:
     View(QWidget *parent = 0);
 
+    /*!
+     * \brief ShowLocalityProfile replaces the chart with one part of a
+     * locality profile. Histograms are plotted as the share of the requests
+     * in every power of two bucket.
+     */
+    void ShowLocalityProfile(const LocalityProfile &profile, LocalityChart chart);
+
 protected:
     void resizeEvent(QResizeEvent *event);
     void mouseMoveEvent(QMouseEvent *event);
 
-public slots:
-    void keepCallout();
-    void tooltip(QPointF point, bool state);
-
 private:
     QGraphicsSimpleTextItem *m_coordX;
     QGraphicsSimpleTextItem *m_coordY;
     QChart *m_chart;
-    Callout *m_tooltip;
-    QList<Callout *> m_callouts;
 };
 
 #endif
@@ -3,13 +3,16 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <memory>
 
 #include <QMessageBox>
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "graphwindow.h"
 
+#include "LocalityProfiler.h"
 #include "PageReplacement.h"
+#include "RefStringParser.h"
 
 
 /*!
@@ -32,6 +35,7 @@ MainWindow::MainWindow(QWidget *parent) :
     // the same as a callback. Do the same for calc page faults button and function.
     connect(ui->btnGenerateReferenceString, SIGNAL (clicked()), this, SLOT (GenerateReferenceString()));
     connect(ui->btnCalculatePageFaults, SIGNAL (clicked()), this, SLOT (CalculatePageFaults()));
+    connect(ui->btnShowLocalityProfile, SIGNAL (clicked()), this, SLOT (ShowLocalityProfile()));
 
     // Set the ranges for the frames and pages
     ui->spinNumFrames->setRange(1, 7);
@@ -44,8 +48,17 @@ MainWindow::MainWindow(QWidget *parent) :
     // Set the value of the reference string to the one detailed in the requirements document
     ui->txtReferenceString->setText(QString::fromStdString("1, 2, 3, 4, 2, 1, 5, 6, 2, 1, 2, 3, 7, 6, 3, 2, 1, 2, 3, 6"));
 
-    // Populate the combo box with the default vars for the algorithsm to be used
-    ui->cmboAlgorithm->addItems(QStringList{"FIFO", "LRU", "OPT"});
+    // Populate the combo box with every algorithm that can be used
+    for (const PageReplacementAlgorithmInfo& info : PageReplacementAlgorithms())
+    {
+        ui->cmboAlgorithm->addItem(QString::fromUtf8(info.name));
+    }
+
+    // Same order as LocalityChart
+    ui->cmboLocalityChart->addItem(tr("Reuse distance"));
+    ui->cmboLocalityChart->addItem(tr("Reuse time"));
+    ui->cmboLocalityChart->addItem(tr("Working set size"));
+    ui->cmboLocalityChart->addItem(tr("Working set timeline"));
 }
 
 /*!
@@ -75,6 +88,30 @@ void MainWindow::GenerateReferenceString()
     ui->txtReferenceString->setText(QString::fromStdString(s));
 }
 
+/*!
+ * \brief MainWindow::ReadReferenceString parses the reference string in the
+ * text box. Page ids may have any number of digits and anything that is not
+ * a page id is pointed out instead of being guessed at.
+ * \param title Title of the warning shown if the string is malformed
+ * \param ref_string Receives the cleaned reference string
+ * \return True if the whole string was valid
+ */
+bool MainWindow::ReadReferenceString(const QString &title, std::vector<int> &ref_string)
+{
+    std::string text = ui->txtReferenceString->text().toStdString();
+    RefStringParser parser;
+    if (!parser.Parse(text, ref_string))
+    {
+        QMessageBox::warning(this, title, QString::fromStdString(parser.Error()));
+        return false;
+    }
+
+    // The algorithms only read the reference string so it is cleaned here
+    // once and handed over without a copy
+    AbstractPageReplacement::CleanRefString(ref_string);
+    return true;
+}
+
 /*!
  * \brief MainWindow::CalculatePageFaults is a slot for the calculate page faults
  * button. This function gets all the information from the GUI and calculates the
@@ -82,48 +119,20 @@ void MainWindow::GenerateReferenceString()
  */
 void MainWindow::CalculatePageFaults()
 {
-    // Get the reference string and ensure that it is valid.
-    // Turn the string from the text box into a stream so we can work with it
-    std::stringstream ss( ui->txtReferenceString->text().toStdString() );
-
-    // Instantiate the ref string vector
+    // Get the reference string and ensure that it is valid
     std::vector<int> ref_string;
-
-    // Push every single digit number into the ref_string array
-    // ignoring any chars that arent single digits. Because the
-    // requirement document bound the page numbers between 0 and
-    // 9 we can get away with doing it this way.
-    for (char c; ss >> c;)
+    if (!ReadReferenceString(tr("Page Fault Calculation"), ref_string))
     {
-        // If the current char is not a digit then we dont care
-        if (!std::isdigit(c))
-        {
-            continue;
-        }
-
-        // If it is a char then sub '0' from it to get its' int value
-        ref_string.push_back(c - '0');
+        return;
     }
 
-
     int num_pages = ui->spinNumPages->value();
     int num_frames = ui->spinNumFrames->value();
-    AbstractPageReplacement* PageReplacement;
 
-    switch(ui->cmboAlgorithm->currentIndex())
-    {
-        case 0:
-            PageReplacement = new FIFOPageReplacement(ref_string, num_pages, num_frames);
-            break;
-        case 1:
-            PageReplacement = new LRUPageReplacement(ref_string, num_pages, num_frames);
-            break;
-        case 2:
-            PageReplacement = new OPTPageReplacement(ref_string, num_pages, num_frames);
-            break;
-        default:
-            break;
-    }
+    // The combo box lists the algorithms in the same order as PageReplacementAlgorithms
+    PageReplacementAlgorithm algorithm = PageReplacementAlgorithms()[ui->cmboAlgorithm->currentIndex()].algorithm;
+    std::unique_ptr<AbstractPageReplacement> PageReplacement =
+            CreatePageReplacement(algorithm, RefStringView(ref_string), num_pages, num_frames);
 
     int page_faults = PageReplacement->CalculatePageFaults();
     QString status = QString("This configuration will give %1 page fault(s)").arg(page_faults);
@@ -131,6 +140,32 @@ void MainWindow::CalculatePageFaults()
 
 }
 
+/*!
+ * \brief MainWindow::ShowLocalityProfile is a slot for the show locality
+ * button. It profiles the reference string in the text box and opens a chart
+ * window with the part of the profile picked in the combo box.
+ */
+void MainWindow::ShowLocalityProfile()
+{
+    std::vector<int> ref_string;
+    if (!ReadReferenceString(tr("Locality Profile"), ref_string))
+    {
+        return;
+    }
+
+    // The timeline gets about 20 points whatever the length of the string
+    int timeline_window = std::max(1, (int) ref_string.size() / 20);
+    LocalityProfile profile = ProfileLocality(RefStringView(ref_string), timeline_window);
+
+    // The window is its own top level window and goes away when closed
+    View *view = new View;
+    view->setAttribute(Qt::WA_DeleteOnClose);
+    view->setWindowTitle(tr("Locality Profile"));
+    view->ShowLocalityProfile(profile, static_cast<LocalityChart>(ui->cmboLocalityChart->currentIndex()));
+    view->resize(640, 480);
+    view->show();
+}
+
 MainWindow::~MainWindow()
 {
     delete ui;
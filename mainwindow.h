@@ -2,6 +2,7 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <vector>
 
 namespace Ui {
 class MainWindow;
@@ -18,8 +19,11 @@ public:
 private slots:
     void GenerateReferenceString();
     void CalculatePageFaults();
+    void ShowLocalityProfile();
 
 private:
+    bool ReadReferenceString(const QString &title, std::vector<int> &ref_string);
+
     Ui::MainWindow *ui;
 };
 